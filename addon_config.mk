@@ -30,6 +30,9 @@ common:
 	# but if the addon or addon libraries need special search paths they can be
 	# specified here separated by spaces or one per line using +=
 	# ADDON_INCLUDES =
+	# cereal (header only, https://github.com/USCiLab/cereal v1.3.x) for the binary manifest,
+	# copy its include/ folder to libs/cereal/include, only ofxZEDDatabase.cpp includes it
+	ADDON_INCLUDES += libs/cereal/include
 	
 	# any special flag that should be passed to the compiler when using this
 	# addon
@@ -96,6 +99,8 @@ linux64:
 	ADDON_LIBS += /usr/local/zed/lib/libsl_input.so
 	ADDON_LIBS += /usr/local/zed/lib/libsl_svo.so
 	ADDON_LIBS += /usr/local/zed/lib/libsl_zed.so
+	# shm_open for the shared frame ring
+	ADDON_LDFLAGS += -lrt
 vs:
 	# After compiling copy the following dynamic libraries to the executable directory
 	# only windows visual studio
@@ -35,6 +35,7 @@ void ofApp::setup(){
     print = "";
 
     string newDbPath = ofFilePath::join(currentRoot, "/_presentation/");
+    vector<ofxZED::SVO *> selected;
 
     for (auto & range : ranges) {
         print += range.name + "\n";
@@ -51,20 +52,16 @@ void ofApp::setup(){
         vector<ofxZED::SVO *> svos = db.getFilteredByRange( start, end );
         for (auto & svo : svos) {
             print += svo->filename + "\n";
-            ofFile svoFile( svo->path );
-
-            /*-- copy SVOs to new folder and new database --*/
-
-            svoFile.copyTo( ofFilePath::join(newDbPath, svo->filename));
+            if (std::find(selected.begin(), selected.end(), svo) == selected.end()) selected.push_back(svo);
         }
         print += "\n";
 
     }
 
-    /*-- save new Database for only SVOs in ranges --*/
+    /*-- derive new Database for only SVOs in ranges, linking files and reusing their tables --*/
 
     ofxZED::Database newDb;
-    newDb.build( newDbPath);
+    newDb.derive( selected, newDbPath );
 
     ofLog() << print;
 }
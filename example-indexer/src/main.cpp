@@ -0,0 +1,296 @@
+#include "ofMain.h"
+#include "ofxZEDSVO.h"
+#include "ofxZEDDatabase.h"
+#include "ofxZEDPoseFile.h"
+#include "ofxZEDScraper.h"
+#include "ofxZEDVoxelGrid.h"
+
+/*
+
+Headless indexer, no window or GL context is created
+
+    indexer build <directory> [--name _database] [--workers N] [--segments K] [--lookup] [--force] [--poses]
+    indexer verify <directory> [--name _database] [--workers N] [--repair]
+    indexer query <directory> --from "14/08/2019 11:24:00" --to "14/08/2019 11:28:10" [--name _database] [--region x0,y0,z0,x1,y1,z1]
+    indexer poses <directory> [--precision 0.001]
+    indexer bench <directory> [--entries 10000]
+    indexer check [--segments K]
+
+--trace writes a Chrome trace-event file of the run, ie. --trace trace.json
+--metrics prints grab, scrape and load timings before exiting
+--poses also builds the pose index, --region then lists the frames where someone stood inside the box
+query never writes, stale, missing and unindexed files are listed on stderr (run build to update)
+bench times the binary manifest against the json one on synthetic entries written to <directory>
+poses writes a .svo.poses.bin next to every .svo.poses and reports its round-trip error
+check runs the segmented scraper and the voxel grid on synthetic data, no SVO or directory is needed
+
+exit codes
+
+    0   success
+    1   usage error
+    2   files failed to index, or verify found problems
+
+**/
+
+enum ExitCode {
+    EXIT_OK = 0,
+    EXIT_USAGE = 1,
+    EXIT_FAILED = 2
+};
+
+struct Arguments {
+    string command;
+    string directory;
+    string name = "_database";
+    string from, to;
+    string region;
+    float precision = 0.001;
+    int workers = 1;
+    int entries = 10000;
+    int segments = 1;
+    bool withLookup = false;
+    bool force = false;
+    bool repair = false;
+    bool withPoses = false;
+    bool metrics = false;
+    string trace;
+};
+
+int usage() {
+    std::cerr << "usage:" << std::endl;
+    std::cerr << "  indexer build <directory> [--name _database] [--workers N] [--segments K] [--lookup] [--force] [--poses]" << std::endl;
+    std::cerr << "  indexer verify <directory> [--name _database] [--workers N] [--repair]" << std::endl;
+    std::cerr << "  indexer poses <directory> [--precision 0.001]" << std::endl;
+    std::cerr << "  indexer bench <directory> [--entries 10000]" << std::endl;
+    std::cerr << "  indexer check [--segments K]" << std::endl;
+    std::cerr << "  indexer query <directory> --from \"dd/mm/YYYY HH:MM:SS\" --to \"dd/mm/YYYY HH:MM:SS\" [--name _database] [--region x0,y0,z0,x1,y1,z1]" << std::endl;
+    return EXIT_USAGE;
+}
+
+bool parse(int argc, char *argv[], Arguments & args) {
+    if (argc < 2) return false;
+    args.command = argv[1];
+    int i = 2;
+    if (args.command != "check") {
+        if (argc < 3) return false;
+        args.directory = ofFilePath::getAbsolutePath(argv[i++], false);
+    }
+    for (; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--name" && hasValue) args.name = argv[++i];
+        else if (arg == "--workers" && hasValue) args.workers = std::max(1, ofToInt(argv[++i]));
+        else if (arg == "--entries" && hasValue) args.entries = std::max(1, ofToInt(argv[++i]));
+        else if (arg == "--segments" && hasValue) args.segments = std::max(1, ofToInt(argv[++i]));
+        else if (arg == "--from" && hasValue) args.from = argv[++i];
+        else if (arg == "--to" && hasValue) args.to = argv[++i];
+        else if (arg == "--region" && hasValue) args.region = argv[++i];
+        else if (arg == "--precision" && hasValue) args.precision = ofToFloat(argv[++i]);
+        else if (arg == "--lookup") args.withLookup = true;
+        else if (arg == "--force") args.force = true;
+        else if (arg == "--repair") args.repair = true;
+        else if (arg == "--poses") args.withPoses = true;
+        else if (arg == "--metrics") args.metrics = true;
+        else if (arg == "--trace" && hasValue) args.trace = argv[++i];
+        else return false;
+    }
+    return true;
+}
+
+/*-- progress and throughput, printed as each file finishes --*/
+
+void printProgress(ofxZED::Progress & p) {
+    float seconds = std::max(p.elapsed, 0.001f);
+    std::cout << "[" << p.file << "/" << p.total << "] " << p.filename;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  " << (p.file / seconds) << " files/s";
+    std::cout << "  " << (p.frames / seconds) << " frames/s";
+    if (p.failed > 0) std::cout << "  " << p.failed << " failed";
+    std::cout << std::endl;
+}
+
+int build(Arguments & args) {
+    ofxZED::Database db;
+    db.workers = args.workers;
+    db.segments = args.segments;
+    db.withPoseIndex = args.withPoses;
+    ofEventListener listener = db.progressEvent.newListener(printProgress);
+    db.build(args.directory, args.name, args.withLookup, args.force);
+    std::cout << "indexed " << db.data.size() << " files, " << db.totalFrames << " new frames" << std::endl;
+    for (auto & f : db.failed) std::cerr << "failed: " << f << std::endl;
+    return db.failed.empty() ? EXIT_OK : EXIT_FAILED;
+}
+
+/*-- verifies every table in parallel from the manifest alone, nothing is scraped --*/
+
+int verify(Arguments & args) {
+    string manifestPath = ofFilePath::join(args.directory, args.name);
+    if (!ofFile::doesFileExist(manifestPath + ".bin", false) && !ofFile::doesFileExist(manifestPath + ".json", false)) {
+        std::cerr << "no manifest at " << manifestPath << ".bin" << std::endl;
+        return EXIT_FAILED;
+    }
+
+    ofxZED::Database db;
+    db.workers = args.workers;
+    db.loadManifest(args.directory, args.name);
+    ofJson report = db.verify(args.repair);
+
+    for (auto & entry : report["entries"]) {
+        if (entry["status"].get<string>() == "ok") continue;
+        std::cout << entry["status"].get<string>() << ": " << entry["filename"].get<string>();
+        for (auto & problem : entry["problems"]) std::cout << ", " << problem.get<string>();
+        std::cout << std::endl;
+    }
+    for (auto & name : report["unindexed"]) std::cout << "not indexed: " << name.get<string>() << std::endl;
+    std::cout << report["summary"].dump() << std::endl;
+
+    int problems = report["summary"]["failed"].get<int>() + report["summary"]["problems"].get<int>() + report["summary"]["unindexed"].get<int>();
+    return (problems == 0) ? EXIT_OK : EXIT_FAILED;
+}
+
+/*-- converts every .svo.poses to .svo.poses.bin, checking each by reading it back --*/
+
+int poses(Arguments & args) {
+    if (args.precision <= 0) return usage();
+
+    ofDirectory dir;
+    dir.allowExt("poses");
+    dir.listDir(args.directory);
+
+    int failures = 0;
+    for (auto & f : dir.getFiles()) {
+        string jsonPath = f.getAbsolutePath();
+        ofJson report = ofxZED::PoseFile::convert(jsonPath, jsonPath + ".bin", args.precision);
+        std::cout << report.dump() << std::endl;
+        if (!report["ok"].get<bool>()) failures++;
+    }
+    std::cout << "converted " << dir.size() - failures << " of " << dir.size() << " pose files" << std::endl;
+    return (failures == 0) ? EXIT_OK : EXIT_FAILED;
+}
+
+/*-- synthetic manifest, every entry as a real build would write it --*/
+
+int bench(Arguments & args) {
+
+    ofxZED::Database db;
+    uint64_t start = 1565774640000000000ULL;
+    for (int i = 0; i < args.entries; i++) {
+        std::shared_ptr<ofxZED::SVO> svo = std::make_shared<ofxZED::SVO>();
+        svo->filename = "bench_" + ofToString(i, 6, '0') + ".svo";
+        svo->path = ofFilePath::join(args.directory, svo->filename);
+        svo->fps = 30;
+        svo->fileSize = 1000000000ULL + i;
+        svo->fileModified = 1565774640 + i;
+        svo->frames.push_back( ofxZED::Frame(0, start + (uint64_t) i * 600000000000ULL) );
+        svo->frames.push_back( ofxZED::Frame(1, start + (uint64_t) i * 600000000000ULL + 599000000000ULL) );
+        db.data.push_back(svo);
+    }
+
+    string binPath = ofFilePath::join(args.directory, "_bench.bin");
+    string jsonPath = ofFilePath::join(args.directory, "_bench.json");
+    vector<std::shared_ptr<ofxZED::SVO>> entries;
+    auto time = [](std::function<void()> f) {
+        float t = ofGetElapsedTimef();
+        f();
+        return ofGetElapsedTimef() - t;
+    };
+
+    float binWrite = time([&]() { db.writeBinary(binPath); });
+    float binRead = time([&]() { db.readBinary(binPath, entries); });
+    bool binOk = entries.size() == args.entries;
+    float jsonWrite = time([&]() { db.exportJson(jsonPath); });
+    float jsonRead = time([&]() { db.importJson(jsonPath, entries); });
+    bool jsonOk = entries.size() == args.entries;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << args.entries << " entries" << std::endl;
+    std::cout << "binary  write " << binWrite << "s  read " << binRead << "s  " << ofFile(binPath).getSize() << " bytes" << std::endl;
+    std::cout << "json    write " << jsonWrite << "s  read " << jsonRead << "s  " << ofFile(jsonPath).getSize() << " bytes" << std::endl;
+
+    ofFile::removeFile(binPath, false);
+    ofFile::removeFile(jsonPath, false);
+    return (binOk && jsonOk) ? EXIT_OK : EXIT_FAILED;
+}
+
+/*-- self checks that need neither a camera nor recordings --*/
+
+int check(Arguments & args) {
+    bool scraper = ofxZED::Scraper::check(10000, std::max(2, args.segments));
+    bool voxels = ofxZED::VoxelGrid::check();
+    std::cout << "scraper " << (scraper ? "ok" : "FAILED") << std::endl;
+    std::cout << "voxels " << (voxels ? "ok" : "FAILED") << std::endl;
+    return (scraper && voxels) ? EXIT_OK : EXIT_FAILED;
+}
+
+int query(Arguments & args) {
+    if (args.from.empty() || args.to.empty()) return usage();
+    uint64_t start = ofxZED::SVO::getTimestampFromStr(args.from);
+    uint64_t end = ofxZED::SVO::getTimestampFromStr(args.to);
+
+    /*-- read-only: answered from the manifest as it is, files that changed since the last build
+     * are reported on stderr and left to build or verify --*/
+
+    ofxZED::Database db;
+    db.loadFast(args.directory, args.name, false);
+
+    std::set<string> known;
+    for (auto & svo : *db.getSnapshot()) {
+        known.insert(svo->filename);
+        uint64_t size;
+        int64_t modified;
+        if (!svo->readFingerprint(size, modified)) std::cerr << "missing: " << svo->filename << std::endl;
+        else if (svo->fileSize > 0 && (size != svo->fileSize || modified != svo->fileModified)) std::cerr << "stale: " << svo->filename << std::endl;
+    }
+    ofDirectory dir;
+    dir.allowExt("svo");
+    dir.listDir(args.directory);
+    for (auto & f : dir.getFiles()) {
+        if (known.find(f.getFileName()) == known.end()) std::cerr << "not indexed: " << f.getFileName() << std::endl;
+    }
+
+    if (!args.region.empty()) {
+        vector<float> r;
+        for (auto & v : ofSplitString(args.region, ",")) r.push_back(ofToFloat(v));
+        if (r.size() != 6) return usage();
+        for (auto & hit : db.poseIndex.query(ofVec3f(r[0], r[1], r[2]), ofVec3f(r[3], r[4], r[5]), start, end)) {
+            std::cout << db.poseIndex.getFilename(hit) << "," << hit.frame << "," << hit.timestamp << ",";
+            std::cout << hit.center.x << "," << hit.center.y << "," << hit.center.z << std::endl;
+        }
+        return EXIT_OK;
+    }
+
+    for (auto & svo : db.getFilteredByRange(start, end)) {
+        std::cout << svo->getSVOPath() << "," << svo->getStart() << "," << svo->getEnd() << std::endl;
+    }
+    return EXIT_OK;
+}
+
+//========================================================================
+int main(int argc, char *argv[] ){
+
+    ofInit();
+    ofSetDataPathRoot(ofFilePath::getCurrentWorkingDirectory() + "/");
+    ofLog::setAutoSpace(true);
+
+    Arguments args;
+    if (!parse(argc, argv, args)) return usage();
+
+    ofxZED::Metrics::enabled = args.metrics;
+    if (!args.trace.empty()) ofxZED::Trace::start();
+
+    int code = EXIT_USAGE;
+    if (args.command == "build") code = build(args);
+    else if (args.command == "verify") code = verify(args);
+    else if (args.command == "poses") code = poses(args);
+    else if (args.command == "bench") code = bench(args);
+    else if (args.command == "query") code = query(args);
+    else if (args.command == "check") code = check(args);
+    else return usage();
+
+    if (args.metrics) std::cout << ofxZED::Metrics::getText();
+    if (!args.trace.empty()) {
+        ofxZED::Trace::stop();
+        ofxZED::Trace::write(args.trace);
+    }
+    return code;
+}
@@ -26,6 +26,13 @@ NB! make a function "guessDroppedFrames()"
 
 ofxZED::Camera::Camera() {
     stereoOffset = 0;
+    isListeningToExit = false;
+}
+
+ofxZED::Camera::~Camera() {
+    if (isListeningToExit && ofGetWindowPtr() != nullptr) {
+        ofRemoveListener(ofGetWindowPtr()->events().exit, this, &ofxZED::Camera::close);
+    }
 }
 
 int ofxZED::Camera::getSerialNumber() {
@@ -75,33 +82,31 @@ void ofxZED::Camera::processViewAndDepth(sl::Mat & matL, sl::Mat & matD, ofPixel
     }
 }
 
-void ofxZED::Camera::processMatToPix(ofPixels & pix, sl::Mat & mat, bool psychedelic) {
+void ofxZED::Camera::processMatToPix(ofPixels & pix, sl::Mat & mat, bool colorize) {
     int w = mat.getWidth();
     int h = mat.getHeight();
+    int step = mat.getStepBytes();
+    const uint8_t * src = mat.getPtr<sl::uchar1>();
+
+    /*-- 8-bit depth views carry the depth in every channel, so the first one indexes the colormap --*/
+
+    if (colorize) {
+        colormap.apply(src, w, h, step, 4, pix);
+        return;
+    }
+
     if (pix.getWidth() != w || pix.getHeight() != h || !pix.isAllocated()) {
         pix.allocate(w, h, 4);
     }
+    unsigned char * dst = pix.getData();
     for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            sl::uchar4  p;
-            mat.getValue<sl::uchar4 >(x, y, &p);
-            int index = 3 * (x + y * w);
-
-            if (!psychedelic) {
-
-                pix[index + 0] = p.b;
-                pix[index + 1] = p.g;
-                pix[index + 2] = p.r;
-                pix[index + 3] = p.a;
-
-            } else {
-
-                pix[index + 0] = p.r;
-                pix[index + 1] = (p.r*2 < 255) ? 255 - (p.r*2) : 0;
-                pix[index + 2] = (p.r > 255/2) ? (255) - (p.r - (255/2)) : 255;
-                pix[index + 3] = 255;
-            }
-
+        const uint8_t * row = src + (size_t) y * step;
+        unsigned char * out = dst + (size_t) y * w * 4;
+        for (int x = 0; x < w * 4; x += 4) {
+            out[x + 0] = row[x + 2];
+            out[x + 1] = row[x + 1];
+            out[x + 2] = row[x + 0];
+            out[x + 3] = row[x + 3];
         }
     }
 }
@@ -161,19 +166,30 @@ void ofxZED::Camera::toggleRecording(string path, bool autoPath) {
 }
 void ofxZED::Camera::updateRecording() {
 
+    static ofxZED::Histogram & grabTime = ofxZED::Metrics::histogram("camera.grab");
+    static ofxZED::Counter & recorded = ofxZED::Metrics::counter("camera.recorded_frames");
+
     frameNew = false;
     sl::RuntimeParameters runtime_parameters;
     runtime_parameters.sensing_mode = sl::SENSING_MODE_FILL; // Use STANDARD sensing mode
     runtime_parameters.enable_depth = true;
 
 
-    if (sl::Camera::grab(runtime_parameters) == sl::SUCCESS) {
+    sl::ERROR_CODE code;
+    {
+        ofxZED::ScopedTimer timer(grabTime);
+        OFXZED_TRACE("Camera::grab");
+        code = sl::Camera::grab(runtime_parameters);
+    }
+
+    if (code == sl::SUCCESS) {
 
         frameNew = true;
 
         if (isRecording) {
             sl::RecordingState state = sl::Camera::record();
             if (state.status) frameCount++;
+            if (state.status) recorded.add();
 //                ofLogNotice("ofxZED") << "Frame count: " << frameCount;
         }
     }
@@ -236,12 +252,18 @@ bool ofxZED::Camera::openCamera(int i) {
 
 bool ofxZED::Camera::openWithParams() {
 
+    static ofxZED::Histogram & openTime = ofxZED::Metrics::histogram("camera.open");
+    ofxZED::ScopedTimer timer(openTime);
+    OFXZED_TRACE("Camera::open");
 
 
+    /*-- headless (ie. no window) there is no exit event, owners must close() themselves --*/
+
     if (sl::Camera::isOpened()) {
         sl::Camera::close();
-    } else {
+    } else if (!isListeningToExit && ofGetWindowPtr() != nullptr) {
         ofAddListener(ofGetWindowPtr()->events().exit, this, &ofxZED::Camera::close);
+        isListeningToExit = true;
     }
 
     bool success = false;
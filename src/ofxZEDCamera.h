@@ -2,6 +2,9 @@
 
 #include "ofMain.h"
 #include <sl/Camera.hpp>
+#include "ofxZEDMetrics.h"
+#include "ofxZEDTrace.h"
+#include "ofxZEDColormap.h"
 
 /* 
 
@@ -52,18 +55,23 @@ namespace ofxZED {
 
 
         ofMesh mesh;
+
+        /*-- colorizes depth in processMatToPix and Player::grab --*/
+        Colormap colormap;
         sl::InitParameters init;
         int frameCount = 0;
         bool isRecording = false;
         bool frameNew = false;
+        bool isListeningToExit;
 
         Camera();
+        ~Camera();
 
         int getSerialNumber();
 
         void logSerial();
 
-        void processMatToPix(ofPixels & pix, sl::Mat & mat, bool psychedelic = false);
+        void processMatToPix(ofPixels & pix, sl::Mat & mat, bool colorize = false);
         void processViewAndDepth(sl::Mat & matL, sl::Mat & matD, ofPixels & pixL, ofPixels & pixD);
 
 
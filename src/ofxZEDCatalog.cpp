@@ -0,0 +1,335 @@
+#include "ofxZEDCatalog.h"
+
+#include <sys/stat.h>
+#include <climits>
+
+
+namespace ofxZED {
+
+    static int64_t getModified(string path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return 0;
+        return st.st_mtime;
+    }
+
+    /*-- symbolic links resolved, so a directory reached through a link is recognised --*/
+
+    static string getCanonicalPath(string path) {
+#ifndef TARGET_WIN32
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved) != nullptr) return resolved;
+#endif
+        return ofFilePath::removeTrailingSlash(ofFilePath::getAbsolutePath(path, false));
+    }
+
+    Catalog::Catalog() {
+        databaseName = "_database";
+        catalogName = "_catalog";
+        withLookup = false;
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    void Catalog::addRoot(string path) {
+        string root = ofFilePath::getAbsolutePath(path);
+        if (std::find(roots.begin(), roots.end(), root) == roots.end()) roots.push_back(root);
+    }
+
+    void Catalog::open(vector<string> roots_, string databaseName_) {
+        databaseName = databaseName_;
+        for (auto & r : roots_) addRoot(r);
+        scan();
+    }
+
+    /*-- find every directory with SVOs, but do not load anything yet --*/
+
+    void Catalog::scan() {
+
+        float ts = ofGetElapsedTimef();
+        std::set<string> visited;
+        for (auto & root : roots) {
+            scanDirectory(root, root, visited);
+            readSummary(root);
+        }
+        ofLogNotice("ofxZED::Catalog") << "found" << entries.size() << "directories in" << roots.size() << "roots, took" << ofGetElapsedTimef() - ts << "seconds";
+    }
+
+    /*-- linked directories are followed once, a link back to an ancestor is not rescanned --*/
+
+    void Catalog::scanDirectory(string root, string path, std::set<string> & visited) {
+
+        if (!visited.insert(getCanonicalPath(path)).second) return;
+
+        ofDirectory d(path);
+        d.listDir();
+
+        int svoCount = 0;
+        int64_t svoModified = 0;
+        for (int i = 0; i < d.size(); i++) {
+            ofFile f = d.getFile(i);
+            string name = d.getName(i);
+            if (f.isDirectory()) {
+                if (name.size() > 0 && (name[0] == '.' || name[0] == '_')) continue;
+                scanDirectory(root, f.getAbsolutePath(), visited);
+            } else if (ofToLower(f.getExtension()) == "svo") {
+                svoCount++;
+                svoModified = std::max(svoModified, getModified(f.getAbsolutePath()));
+            }
+        }
+
+        if (svoCount == 0) return;
+
+        string directory = d.getAbsolutePath();
+        for (auto & e : entries) if (e->directory == directory) return;
+
+        std::unique_ptr<Entry> e(new Entry());
+        e->root = root;
+        e->directory = directory;
+        e->start = 0;
+        e->end = 0;
+        e->files = 0;
+        e->svoCount = svoCount;
+        e->svoModified = svoModified;
+        e->manifestModified = 0;
+        e->hasSummary = false;
+        e->isLoaded = false;
+        entries.push_back(std::move(e));
+    }
+
+    int64_t Catalog::getManifestModified(Entry & e) {
+        string manifestPath = ofFilePath::join(e.directory, databaseName);
+        int64_t modified = getModified(manifestPath + ".bin");
+        return (modified != 0) ? modified : getModified(manifestPath + ".json");
+    }
+
+    /*-- the summary lets range queries skip directories without loading them,
+     * as long as nothing was recorded, added or rebuilt there since it was written --*/
+
+    void Catalog::readSummary(string root) {
+
+        string summaryPath = ofFilePath::join(root, catalogName + ".json");
+        if (!ofFile::doesFileExist(summaryPath, false)) return;
+
+        ofJson j = ofLoadJson(summaryPath);
+        int stale = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & e : entries) {
+            if (e->root != root) continue;
+            string key = ofFilePath::makeRelative(root, e->directory);
+            if (j["directories"].find(key) == j["directories"].end()) continue;
+
+            ofJson & summary = j["directories"][key];
+            int64_t manifestModified = getManifestModified(*e);
+            bool isCurrent = summary.value("svoCount", -1) == e->svoCount
+                && summary.value("svoModified", (int64_t) -1) == e->svoModified
+                && summary.value("manifestModified", (int64_t) -1) == manifestModified;
+            if (!isCurrent) {
+                stale++;
+                continue;
+            }
+            e->start = summary["start"].get<uint64_t>();
+            e->end = summary["end"].get<uint64_t>();
+            e->files = summary["files"].get<int>();
+            e->manifestModified = manifestModified;
+            e->hasSummary = true;
+        }
+        if (stale > 0) ofLogNotice("ofxZED::Catalog") << "dropped" << stale << "stale summaries in" << summaryPath;
+    }
+
+    void Catalog::save() {
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & root : roots) {
+            ofJson j;
+            for (auto & e : entries) {
+                if (e->root != root || !e->hasSummary) continue;
+                string key = ofFilePath::makeRelative(root, e->directory);
+                j["directories"][key]["start"] = e->start;
+                j["directories"][key]["end"] = e->end;
+                j["directories"][key]["files"] = e->files;
+                j["directories"][key]["svoCount"] = e->svoCount;
+                j["directories"][key]["svoModified"] = e->svoModified;
+                j["directories"][key]["manifestModified"] = e->manifestModified;
+            }
+            ofSaveJson(ofFilePath::join(root, catalogName + ".json"), j);
+        }
+    }
+
+    void Catalog::loadEntry(Entry & e) {
+
+        std::call_once(e.loaded, [&]() {
+            ofLogNotice("ofxZED::Catalog") << "loading" << e.directory;
+            std::unique_ptr<Database> db(new Database());
+            if (withLookup) {
+                db->load(e.directory, databaseName, withLookup);
+            } else {
+
+                /*-- validated before the range is read, so the summary never lags a rescrape --*/
+
+                db->loadFast(e.directory, databaseName, false);
+                db->validate();
+            }
+
+            uint64_t start = db->getStart();
+            uint64_t end = db->getEnd();
+            int64_t manifestModified = getManifestModified(e);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            e.start = start;
+            e.end = end;
+            e.files = db->getSnapshot()->size();
+            e.manifestModified = manifestModified;
+            e.hasSummary = true;
+            e.db = std::move(db);
+            e.isLoaded = true;
+        });
+    }
+
+    /*-- each Database owns its own Camera, so directories can be loaded side by side --*/
+
+    void Catalog::loadEntries(vector<Entry *> list) {
+
+        int workers = std::min(threads, (int)list.size());
+        if (workers <= 1) {
+            for (auto & e : list) loadEntry(*e);
+            return;
+        }
+
+        std::atomic<int> next(0);
+        vector<std::thread> pool;
+        for (int i = 0; i < workers; i++) {
+            pool.emplace_back([&]() {
+                int idx;
+                while ((idx = next++) < list.size()) loadEntry(*list[idx]);
+            });
+        }
+        for (auto & t : pool) t.join();
+    }
+
+    void Catalog::load() {
+
+        float ts = ofGetElapsedTimef();
+        vector<Entry *> list;
+        for (auto & e : entries) list.push_back(e.get());
+        loadEntries(list);
+        save();
+        ofLogNotice("ofxZED::Catalog") << "loaded" << list.size() << "directories, took" << ofGetElapsedTimef() - ts << "seconds";
+    }
+
+    bool Catalog::isLoaded() {
+        for (auto & e : entries) if (!e->isLoaded) return false;
+        return true;
+    }
+
+    int Catalog::getNumDirectories() {
+        return entries.size();
+    }
+
+    vector<string> Catalog::getDirectories() {
+        vector<string> dirs;
+        for (auto & e : entries) dirs.push_back(e->directory);
+        return dirs;
+    }
+
+    Database * Catalog::getDatabase(string directory) {
+        string path = ofFilePath::removeTrailingSlash(ofFilePath::getAbsolutePath(directory));
+        for (auto & e : entries) {
+            if (ofFilePath::removeTrailingSlash(e->directory) == path) {
+                loadEntry(*e);
+                return e->db.get();
+            }
+        }
+        ofLogError("ofxZED::Catalog") << "directory is not in catalog" << directory;
+        return nullptr;
+    }
+
+    /*-- directories without a summary have an unknown range, so are always included --*/
+
+    vector<Catalog::Entry *> Catalog::getEntriesInRange(uint64_t start, uint64_t end) {
+
+        vector<Entry *> list;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & e : entries) {
+            if (!e->hasSummary || (e->start <= end && e->end >= start)) list.push_back(e.get());
+        }
+        lock.unlock();
+        bool hadNew = false;
+        for (auto & e : list) if (!e->isLoaded) hadNew = true;
+        loadEntries(list);
+        if (hadNew) save();
+        return list;
+    }
+
+    /*-- only directories without a summary have to be loaded to know their range --*/
+
+    void Catalog::loadUnsummarized() {
+
+        vector<Entry *> list;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & e : entries) if (!e->hasSummary) list.push_back(e.get());
+        lock.unlock();
+        if (list.empty()) return;
+        loadEntries(list);
+        save();
+    }
+
+    uint64_t Catalog::getStart() {
+        loadUnsummarized();
+        uint64_t start = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & e : entries) {
+            if (e->files == 0) continue;
+            if (start == 0 || e->start < start) start = e->start;
+        }
+        return start;
+    }
+
+    uint64_t Catalog::getEnd() {
+        loadUnsummarized();
+        uint64_t end = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & e : entries) {
+            if (e->files == 0) continue;
+            if (e->end > end) end = e->end;
+        }
+        return end;
+    }
+
+    /*-- every entry of every directory, so this one does load the whole catalog --*/
+
+    vector<SVO *> Catalog::getPtrs() {
+        vector<SVO *> db;
+        for (auto & e : getEntriesInRange(0, std::numeric_limits<uint64_t>::max())) {
+            for (auto & d : e->db->getPtrs()) db.push_back(d);
+        }
+        ofSort(db, ofxZED::SVO::sortSVOPtrs);
+        return db;
+    }
+
+    vector<SVO *> Catalog::getFilteredByRange( uint64_t start, uint64_t end) {
+        vector<SVO *> db;
+        for (auto & e : getEntriesInRange(start, end)) {
+            for (auto & d : e->db->getFilteredByRange(start, end)) db.push_back(d);
+        }
+        ofSort(db, ofxZED::SVO::sortSVOPtrs);
+        return db;
+    }
+
+    vector<SVO *> Catalog::getPtrsInsideTimestamp(uint64_t time) {
+        vector<SVO *> db;
+        for (auto & e : getEntriesInRange(time, time)) {
+            for (auto & d : e->db->getPtrsInsideTimestamp(time)) db.push_back(d);
+        }
+        ofSort(db, ofxZED::SVO::sortSVOPtrs);
+        return db;
+    }
+
+    std::map<string, vector<SVO *>> Catalog::getSortedByDay(vector<SVO *> svos) {
+        return Database::getSortedByDay(svos);
+    }
+
+    std::map<string, vector<SVO *>> Catalog::getSortedBySerialNumber(vector<SVO *> svos) {
+        return Database::getSortedBySerialNumber(svos);
+    }
+
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDSVO.h"
+#include "ofxZEDDatabase.h"
+
+/*
+
+Catalog: one Database per directory, many roots
+
+- roots are scanned recursively for directories containing .svo files
+- every directory keeps its own manifest (ie. _database.json) as before
+- a _catalog.json summary is kept per root with the start / end of every directory,
+  so range queries only load the directories that can overlap
+- each summary keeps a fingerprint of its directory (manifest mtime, .svo count and newest
+  .svo mtime), a summary whose fingerprint no longer matches is dropped and reloaded
+- directories are loaded lazily on first use, or in parallel via load()
+- directories starting with "." or "_" are skipped (ie. derived "_presentation" sets)
+- symbolic links to directories are followed, but every directory is scanned only once
+- getStart() / getEnd() come from the summaries, only unsummarized directories are loaded
+
+**/
+
+
+namespace ofxZED {
+
+    class Catalog {
+    private:
+
+        struct Entry {
+            string root;
+            string directory;
+            uint64_t start;
+            uint64_t end;
+            int files;
+            int svoCount;
+            int64_t svoModified;
+            int64_t manifestModified;
+            bool hasSummary;
+            std::atomic<bool> isLoaded;
+            std::once_flag loaded;
+            std::unique_ptr<Database> db;
+        };
+
+        vector<std::unique_ptr<Entry>> entries;
+        std::mutex mutex;
+
+        void scanDirectory(string root, string path, std::set<string> & visited);
+        int64_t getManifestModified(Entry & e);
+        void readSummary(string root);
+        void loadEntry(Entry & e);
+        void loadEntries(vector<Entry *> list);
+        void loadUnsummarized();
+        vector<Entry *> getEntriesInRange(uint64_t start, uint64_t end);
+
+    public:
+
+        vector<string> roots;
+        string databaseName;
+        string catalogName;
+        bool withLookup;
+        int threads;
+
+        Catalog();
+
+        void addRoot(string path);
+        void open(vector<string> roots_, string databaseName_ = "_database");
+        void scan();
+        void load();
+        void save();
+
+        bool isLoaded();
+        int getNumDirectories();
+        vector<string> getDirectories();
+        Database * getDatabase(string directory);
+
+        /*-- merged queries, same semantics as Database --*/
+
+        uint64_t getStart();
+        uint64_t getEnd();
+
+        vector<SVO *> getPtrs();
+        vector<SVO *> getFilteredByRange( uint64_t start, uint64_t end);
+        vector<SVO *> getPtrsInsideTimestamp(uint64_t time);
+        std::map<string, vector<SVO *>> getSortedByDay(vector<SVO *> svos);
+        std::map<string, vector<SVO *>> getSortedBySerialNumber(vector<SVO *> svos);
+    };
+
+
+}
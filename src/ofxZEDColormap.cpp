@@ -0,0 +1,214 @@
+#include "ofxZEDColormap.h"
+#include "ofxZEDMetrics.h"
+#include "ofxZEDTrace.h"
+
+
+namespace ofxZED {
+
+    /*-- RGBA bytes in memory order, ofPixels rows are written as uint32_t --*/
+
+    static uint32_t pack(const ofColor & c) {
+        return (uint32_t) c.r | ((uint32_t) c.g << 8) | ((uint32_t) c.b << 16) | ((uint32_t) c.a << 24);
+    }
+
+    static ofColor interpolate(const vector<ofColor> & stops, float t) {
+        float f = t * (stops.size() - 1);
+        int i = std::min((int) f, (int) stops.size() - 2);
+        float a = f - i;
+        const ofColor & c0 = stops[i];
+        const ofColor & c1 = stops[i + 1];
+        return ofColor(c0.r + (c1.r - c0.r) * a, c0.g + (c1.g - c0.g) * a, c0.b + (c1.b - c0.b) * a, 255);
+    }
+
+    Colormap::Colormap() {
+        type = COLORMAP_TURBO;
+        nearDepth = 0.3;
+        farDepth = 10;
+        invert = false;
+        isDirty = true;
+        measureBins = 1024;
+        threads = 1;
+        invalidColor = ofColor(0, 0, 0, 0);
+    }
+
+    void Colormap::setType(ColormapType type_) {
+        if (type_ != type) isDirty = true;
+        type = type_;
+    }
+
+    void Colormap::setRange(float nearDepth_, float farDepth_) {
+        nearDepth = nearDepth_;
+        farDepth = std::max(farDepth_, nearDepth_ + 0.001f);
+    }
+
+    void Colormap::setInvert(bool invert_) {
+        if (invert_ != invert) isDirty = true;
+        invert = invert_;
+    }
+
+    ColormapType Colormap::getType() {
+        return type;
+    }
+
+    float Colormap::getNear() {
+        return nearDepth;
+    }
+
+    float Colormap::getFar() {
+        return farDepth;
+    }
+
+    ofColor Colormap::getColor(ColormapType type, float t) {
+
+        t = ofClamp(t, 0, 1);
+
+        if (type == COLORMAP_GRAY) {
+            return ofColor(t * 255, t * 255, t * 255, 255);
+
+        } else if (type == COLORMAP_JET) {
+            float r = ofClamp(1.5 - std::abs(4 * t - 3), 0, 1);
+            float g = ofClamp(1.5 - std::abs(4 * t - 2), 0, 1);
+            float b = ofClamp(1.5 - std::abs(4 * t - 1), 0, 1);
+            return ofColor(r * 255, g * 255, b * 255, 255);
+
+        } else if (type == COLORMAP_TURBO) {
+
+            /*-- polynomial approximation of Google's Turbo --*/
+
+            float r = 0.13572138 + t * (4.61539260 + t * (-42.66032258 + t * (132.13108234 + t * (-152.94239396 + t * 59.28637943))));
+            float g = 0.09140261 + t * (2.19418839 + t * (4.84296658 + t * (-14.18503333 + t * (4.27729857 + t * 2.82956604))));
+            float b = 0.10667330 + t * (12.64194608 + t * (-60.58204836 + t * (110.36276771 + t * (-89.90310912 + t * 27.34824973))));
+            return ofColor(ofClamp(r, 0, 1) * 255, ofClamp(g, 0, 1) * 255, ofClamp(b, 0, 1) * 255, 255);
+
+        } else if (type == COLORMAP_VIRIDIS) {
+            static const vector<ofColor> stops = {
+                ofColor(68, 1, 84), ofColor(71, 44, 122), ofColor(59, 81, 139), ofColor(44, 113, 142), ofColor(33, 144, 141),
+                ofColor(39, 173, 129), ofColor(92, 200, 99), ofColor(170, 220, 50), ofColor(253, 231, 37)
+            };
+            return interpolate(stops, t);
+
+        } else if (type == COLORMAP_INFERNO) {
+            static const vector<ofColor> stops = {
+                ofColor(0, 0, 4), ofColor(31, 12, 72), ofColor(85, 15, 109), ofColor(136, 34, 106), ofColor(186, 54, 85),
+                ofColor(227, 89, 51), ofColor(249, 140, 10), ofColor(249, 201, 50), ofColor(252, 255, 164)
+            };
+            return interpolate(stops, t);
+
+        } else {
+
+            /*-- the original per-pixel "psychedelic" depth view, now one table entry per value --*/
+
+            int v = t * 255;
+            return ofColor(v, (v * 2 < 255) ? 255 - (v * 2) : 0, (v > 255 / 2) ? 255 - (v - (255 / 2)) : 255, 255);
+        }
+    }
+
+    string Colormap::getName(ColormapType type) {
+        if (type == COLORMAP_GRAY) return "gray";
+        if (type == COLORMAP_JET) return "jet";
+        if (type == COLORMAP_TURBO) return "turbo";
+        if (type == COLORMAP_VIRIDIS) return "viridis";
+        if (type == COLORMAP_INFERNO) return "inferno";
+        return "psychedelic";
+    }
+
+    ColormapType Colormap::fromName(string name) {
+        for (auto & t : getTypes()) if (getName(t) == name) return t;
+        ofLogWarning("ofxZED::Colormap") << "unknown colormap" << name << ", using turbo";
+        return COLORMAP_TURBO;
+    }
+
+    vector<ColormapType> Colormap::getTypes() {
+        return { COLORMAP_GRAY, COLORMAP_JET, COLORMAP_TURBO, COLORMAP_VIRIDIS, COLORMAP_INFERNO, COLORMAP_PSYCHEDELIC };
+    }
+
+    /*-- the measure table has one extra entry at measureBins for invalid depths, set on apply --*/
+
+    void Colormap::rebuild() {
+        viewTable.resize(256);
+        for (int i = 0; i < 256; i++) {
+            float t = i / 255.0;
+            viewTable[i] = pack(getColor(type, invert ? 1 - t : t));
+        }
+
+        int bins = std::max(2, measureBins);
+        measureTable.resize(bins + 1);
+        for (int i = 0; i < bins; i++) {
+            float t = i / (float) (bins - 1);
+            measureTable[i] = pack(getColor(type, invert ? 1 - t : t));
+        }
+        isDirty = false;
+    }
+
+    void Colormap::forRows(int h, std::function<void(int, int)> band) {
+        int count = std::min(std::max(1, threads), h);
+        int rows = (h + count - 1) / count;
+        vector<std::thread> pool;
+        for (int i = 1; i < count; i++) pool.emplace_back(band, i * rows, std::min(h, (i + 1) * rows));
+        band(0, std::min(h, rows));
+        for (auto & t : pool) t.join();
+    }
+
+    void Colormap::apply(const uint8_t * src, int w, int h, int step, int channels, ofPixels & dst) {
+
+        static Histogram & applyTime = Metrics::histogram("colormap.view");
+        ScopedTimer timer(applyTime);
+        OFXZED_TRACE("Colormap::apply");
+
+        if (isDirty) rebuild();
+        if (dst.getWidth() != w || dst.getHeight() != h || dst.getNumChannels() != 4) dst.allocate(w, h, 4);
+
+        const uint32_t * table = viewTable.data();
+        uint32_t * out = (uint32_t *) dst.getData();
+        forRows(h, [&](int from, int to) {
+            for (int y = from; y < to; y++) {
+                const uint8_t * row = src + (size_t) y * step;
+                uint32_t * o = out + (size_t) y * w;
+                for (int x = 0; x < w; x++) o[x] = table[row[x * channels]];
+            }
+        });
+    }
+
+    void Colormap::apply(const float * src, int w, int h, int step, ofPixels & dst) {
+
+        static Histogram & applyTime = Metrics::histogram("colormap.measure");
+        ScopedTimer timer(applyTime);
+        OFXZED_TRACE("Colormap::apply");
+
+        if (isDirty || (int) measureTable.size() != std::max(2, measureBins) + 1) rebuild();
+        if (dst.getWidth() != w || dst.getHeight() != h || dst.getNumChannels() != 4) dst.allocate(w, h, 4);
+        measureTable.back() = pack(invalidColor);
+
+        int bins = measureTable.size() - 1;
+        float last = bins - 1;
+        float scale = last / (farDepth - nearDepth);
+        float offset = nearDepth;
+        float maxDepth = std::numeric_limits<float>::max();
+        const uint32_t * table = measureTable.data();
+        uint32_t * out = (uint32_t *) dst.getData();
+
+        forRows(h, [&](int from, int to) {
+            vector<int32_t> indices(w);
+            int32_t * idx = indices.data();
+            for (int y = from; y < to; y++) {
+                const float * row = src + (size_t) y * step;
+
+                /*-- no branches, NaN fails both comparisons and lands on the invalid entry --*/
+
+                for (int x = 0; x < w; x++) {
+                    float d = row[x];
+                    bool valid = d > 0 && d < maxDepth;
+                    float t = valid ? (d - offset) * scale : 0;
+                    t = t < 0 ? 0 : t;
+                    t = t > last ? last : t;
+                    idx[x] = valid ? (int32_t) t : bins;
+                }
+
+                uint32_t * o = out + (size_t) y * w;
+                for (int x = 0; x < w; x++) o[x] = table[idx[x]];
+            }
+        });
+    }
+
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+
+Colormap: depth to RGBA through precomputed lookup tables
+
+- 8-bit depth views (sl::VIEW_DEPTH) index a 256 entry table directly
+- float depth measures (sl::MEASURE_DEPTH) are windowed to [nearDepth, farDepth] and quantized to
+  measureBins entries, NaN, inf and non-positive depths map to invalidColor
+- tables are rebuilt only when the type or invert flag change, the range is applied per pixel
+- each row is one branchless pass (index, then gather), written so the compiler vectorizes it
+- threads > 1 splits the frame into row bands
+
+    ofxZED::Colormap colormap;
+    colormap.setType(ofxZED::COLORMAP_TURBO);
+    colormap.setRange(0.5, 8.0);
+    colormap.apply(depths, w, h, w, pix);
+
+**/
+
+
+namespace ofxZED {
+
+    enum ColormapType {
+        COLORMAP_GRAY,
+        COLORMAP_JET,
+        COLORMAP_TURBO,
+        COLORMAP_VIRIDIS,
+        COLORMAP_INFERNO,
+        COLORMAP_PSYCHEDELIC
+    };
+
+    class Colormap {
+    private:
+        ColormapType type;
+        float nearDepth, farDepth;
+        bool invert;
+        bool isDirty;
+        vector<uint32_t> viewTable;
+        vector<uint32_t> measureTable;
+
+        void rebuild();
+        void forRows(int h, std::function<void(int, int)> band);
+    public:
+
+        int measureBins;
+        int threads;
+        ofColor invalidColor;
+
+        Colormap();
+
+        void setType(ColormapType type_);
+        void setRange(float nearDepth_, float farDepth_);
+        void setInvert(bool invert_);
+        ColormapType getType();
+        float getNear();
+        float getFar();
+
+        /*-- colour at t in [0, 1] --*/
+        static ofColor getColor(ColormapType type, float t);
+        static string getName(ColormapType type);
+        static ColormapType fromName(string name);
+        static vector<ColormapType> getTypes();
+
+        /*-- 8-bit depth, one byte read per pixel from the first of channels, step in bytes --*/
+        void apply(const uint8_t * src, int w, int h, int step, int channels, ofPixels & dst);
+
+        /*-- float depth, step in floats --*/
+        void apply(const float * src, int w, int h, int step, ofPixels & dst);
+    };
+
+
+}
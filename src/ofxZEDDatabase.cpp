@@ -1,5 +1,19 @@
 #include "ofxZEDDatabase.h"
 
+#include <cereal/cereal.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/archives/binary.hpp>
+
+CEREAL_CLASS_VERSION(ofxZED::SVO, 1);
+
+#ifdef TARGET_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 /* 
 
 ZED SDK: SVO-related methods
@@ -33,24 +47,126 @@ namespace ofxZED {
     void Database::load(string databaseLocation, string databaseName, bool withLookup) {
 
         string loadPath = ofFilePath::join(databaseLocation, databaseName);
-        ofLogNotice("ofxZED::Database") << "loading json database" << loadPath;
-        json = ofLoadJson( loadPath + ".json");
+        ofLogNotice("ofxZED::Database") << "loading database" << loadPath;
+        readManifest(loadPath);
         isForcingRecreate = false;
 
         dir.allowExt("svo");
         dir.open(databaseLocation);
         dir.listDir();
 
+        totalFiles = dir.getFiles().size();
+        currIndex = 0;
+        totalFrames = 0;
+
+        directoryPath = dir.getAbsolutePath();
+        this->databaseName = databaseName;
+
         ofLogNotice("ofxZED::Database") << "loading database";
-        for (auto f : dir.getFiles()) {
-            process(f, withLookup);
-        }
+        processFiles(dir.getFiles(), withLookup);
 
         ofLogNotice("ofxZED::Database") << "finished initing database" << data.size();
         ofLogNotice("ofxZED::Database") << "sorting by date";
 
-        ofSort(data, SVO::sortSVO);
-        if (zed.isOpened()) zed.close();
+        ofSort(data, SVO::sortSVOHandles);
+        publish();
+        loadPoseIndex();
+    }
+
+    /*-- data from the manifest alone, no SVO is opened or scraped --*/
+
+    void Database::loadManifest(string location, string fileName) {
+
+        dir.open(location);
+        directoryPath = dir.getAbsolutePath();
+        databaseName = fileName;
+        readManifest(ofFilePath::join(directoryPath, databaseName));
+
+        data.clear();
+        for (auto & entry : manifest) data.push_back(entry.second);
+        totalFiles = data.size();
+        ofSort(data, SVO::sortSVOHandles);
+        publish();
+    }
+
+    void Database::loadFast(string location, string fileName, bool validateInBackground) {
+
+        float ts = ofGetElapsedTimef();
+        stopValidation();
+        loadManifest(location, fileName);
+        loadPoseIndex();
+        ofLogNotice("ofxZED::Database") << "opened" << data.size() << "entries from manifest in" << ofGetElapsedTimef() - ts << "seconds";
+
+        if (!validateInBackground) return;
+        isValidating = true;
+        validator = std::thread([this]() {
+            validate();
+            isValidating = false;
+        });
+    }
+
+    /*-- missing files are only reported, the archive may be on a share that is not mounted yet --*/
+
+    void Database::validate() {
+
+        float ts = ofGetElapsedTimef();
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> current = getSnapshot();
+        std::set<string> known;
+        vector<string> changed;
+        vector<string> missingNow;
+
+        /*-- entries without a fingerprint get a fresh handle, the published ones are never written to --*/
+
+        vector<std::shared_ptr<SVO>> backfilled;
+        for (auto & svo : *current) {
+            known.insert(svo->filename);
+            uint64_t size;
+            int64_t modified;
+            if (!svo->readFingerprint(size, modified)) {
+                missingNow.push_back(svo->filename);
+            } else if (svo->fileSize == 0) {
+                std::shared_ptr<SVO> copy = std::make_shared<SVO>();
+                copy->init(*svo, svo->path);
+                backfilled.push_back(copy);
+            } else if (size != svo->fileSize || modified != svo->fileModified) {
+                changed.push_back(svo->path);
+            }
+        }
+
+        ofDirectory d;
+        d.allowExt("svo");
+        d.listDir(directoryPath);
+        for (auto & f : d.getFiles()) {
+            if (known.find(f.getFileName()) == known.end()) changed.push_back(f.getAbsolutePath());
+        }
+
+        if (backfilled.size() > 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (auto & copy : backfilled) {
+                for (auto & entry : data) if (entry->filename == copy->filename && entry->fileSize == 0) entry = copy;
+            }
+            write(directoryPath, databaseName);
+            publish();
+        }
+
+        for (auto & p : changed) {
+            if (stopValidating) break;
+            updateEntry(p);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        missing = missingNow;
+        ofLogNotice("ofxZED::Database") << "validated" << current->size() << "entries in" << ofGetElapsedTimef() - ts << "seconds," << changed.size() << "new or changed," << missing.size() << "missing";
+    }
+
+    void Database::stopValidation() {
+        stopValidating = true;
+        if (validator.joinable()) validator.join();
+        stopValidating = false;
+    }
+
+    Database::~Database() {
+        stopValidation();
     }
 
     void Database::finish() {
@@ -58,10 +174,29 @@ namespace ofxZED {
 
     }
 
+    void Database::publish() {
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> next = std::make_shared<const vector<std::shared_ptr<SVO>>>(data);
+        std::atomic_store(&snapshot, next);
+    }
+
+    std::shared_ptr<const vector<std::shared_ptr<SVO>>> Database::getSnapshot() {
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> current = std::atomic_load(&snapshot);
+        if (!current) current = std::make_shared<const vector<std::shared_ptr<SVO>>>();
+        return current;
+    }
+
+    string Database::getDirectoryPath() {
+        return directoryPath;
+    }
+
+    string Database::getDatabaseName() {
+        return databaseName;
+    }
+
 
     void Database::build(string location, string fileName, bool withLookup, bool forceRecreate) {
 
-        ofLogNotice("ofxZED::Database") << "opening json database";
+        ofLogNotice("ofxZED::Database") << "opening database";
         isForcingRecreate = forceRecreate;
         dir.allowExt("svo");
         dir.open(location);
@@ -73,112 +208,258 @@ namespace ofxZED {
 
         directoryPath = dir.getAbsolutePath();
         databaseName = fileName;
-        string loadPath = ofFilePath::join(directoryPath, databaseName);
-        json = ofLoadJson(loadPath + ".json");
+        readManifest(ofFilePath::join(directoryPath, databaseName));
 
         ofLogNotice("ofxZED::Database") << "initing database";
-        for (auto f : dir.getFiles()) process(f, withLookup);
+        processFiles(dir.getFiles(), withLookup);
 
         ofLogNotice("ofxZED::Database") << "finished initing database" << data.size();
         ofLogNotice("ofxZED::Database") << "sorting by date";
 
-        ofSort(data, SVO::sortSVO);
-        if (zed.isOpened()) zed.close();
+        ofSort(data, SVO::sortSVOHandles);
         write(directoryPath, databaseName);
+        publish();
+
+        if (withPoseIndex) {
+            loadPoseIndex();
+            buildPoseIndex();
+        }
+    }
 
+    string Database::getPoseIndexPath() {
+        return ofFilePath::join(directoryPath, databaseName + "_poses.idx");
     }
 
+    void Database::buildPoseIndex() {
+        ofLogNotice("ofxZED::Database") << "building pose index";
+        vector<std::shared_ptr<SVO>> handles = getHandles();
+        vector<SVO *> svos;
+        for (auto & d : handles) svos.push_back(d.get());
+        poseIndex.build(svos, workers);
+        poseIndex.save(getPoseIndexPath());
+    }
 
-    void Database::scrape(ofFile & f, vector<Frame> & frames, vector<int> & lookup) {
+    bool Database::loadPoseIndex() {
+        if (!ofFile::doesFileExist(getPoseIndexPath(), false)) return false;
+        return poseIndex.load(getPoseIndexPath());
+    }
 
-        frames.clear();
-        lookup.clear();
+    /*-- scrape a single new or grown file and merge it without a rebuild --*/
 
-        ofLogNotice("ofxZED::Database") << "beginning scrape";
+    bool Database::updateEntry(string filePath) {
 
-        zed.setSVOPosition(0);
-        int total = zed.getSVONumberOfFrames();
+        ofFile f(filePath);
+        if (!f.exists()) {
+            ofLogError("ofxZED::Database") << "cannot update missing file" << filePath;
+            return false;
+        }
 
-        for (int i = 0; i < total; i++) {
+        ofLogNotice("ofxZED::Database") << "updating entry" << f.getFileName();
 
-            float tt = ofGetElapsedTimef();
-            bool timeout = false;
-            while ( zed.grab() != sl::SUCCESS && !timeout )  {
-                if (ofGetElapsedTimef() > tt + 2) {
-                    ofLogError("ofxZED::Database") << "timout";
-                    timeout = true;
-                }
-                sl::sleep_ms(1);
+        /*-- the validator and a Watcher may both update, they share one Camera --*/
+
+        std::unique_lock<std::mutex> zedLock(zedMutex);
+        std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+        if (!zed.openSVO(f.getAbsolutePath())) {
+            ofLogError("ofxZED::Database") << "could not open" << f.getAbsolutePath();
+            return false;
+        }
+        svo->init(f, zed.getCameraFPS());
+        scrape(*svo, zed);
+        zed.close();
+        zedLock.unlock();
+
+        if (svo->getTotalFrames() <= 0) {
+            ofLogError("ofxZED::Database") << "no frames scraped from" << f.getFileName();
+            return false;
+        }
+
+        ofJson lookupJson = svo->getJson(true);
+
+        /*-- swap the handle, readers holding the old one keep a valid SVO --*/
+
+        std::unique_lock<std::mutex> lock(mutex);
+        bool isNew = true;
+        for (auto & d : data) {
+            if (d->filename == svo->filename) {
+                d = svo;
+                isNew = false;
             }
+        }
+        if (isNew) data.push_back(svo);
+        if (isNew) totalFiles += 1;
+        ofSaveJson(svo->getLookupPath(), lookupJson);
+        if (svo->isComplete) svo->removeCheckpoint();
+        if ((withPoseIndex || poseIndex.files.size() > 0) && poseIndex.update(*svo)) poseIndex.save(getPoseIndexPath());
+        write(directoryPath, databaseName);
+        publish();
+        return true;
+    }
 
-            if (!timeout) {
+    void Database::removeEntry(string fileName) {
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto it = data.begin(); it != data.end(); ++it) {
+            if ((*it)->filename == fileName) {
+                ofLogNotice("ofxZED::Database") << "removing entry" << fileName;
+                if ((*it)->hasLookupFile()) ofFile::removeFile((*it)->getLookupPath(), false);
+                if (ofFile::doesFileExist((*it)->getPosesPath(), false)) ofFile::removeFile((*it)->getPosesPath(), false);
+                if ((*it)->hasPosesBinaryFile()) ofFile::removeFile((*it)->getPosesBinaryPath(), false);
+                (*it)->removeCheckpoint();
+                data.erase(it);
+                totalFiles -= 1;
+                break;
+            }
+        }
+        manifest.erase(fileName);
+        if (poseIndex.remove(fileName)) poseIndex.save(getPoseIndexPath());
+        write(directoryPath, databaseName);
+        publish();
+    }
 
-                uint64_t timestamp = zed.getFrameTimestamp();
-                int frameIdx = zed.getSVOPosition()-1;
-                float fps = zed.getCameraFPS();
+    /*-- renames keep their tables, only the paths and sidecars move, the renamed entry is a new
+     * handle so readers of the snapshot never see its strings change --*/
 
-                if (frameIdx != i) {
-                    ofLogError("ofxZED::Database") << "something went wrong:" << frameIdx << "does not equal" << i;
+    void Database::renameEntry(string fromName, string toName) {
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & d : data) {
+            if (d->filename == fromName) {
+                ofLogNotice("ofxZED::Database") << "renaming entry" << fromName << "to" << toName;
+                std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+                svo->init(*d, ofFilePath::join(directoryPath, toName));
+                if (ofFile::doesFileExist(d->getLookupPath(), false)) {
+                    ofFile::moveFromTo(d->getLookupPath(), svo->getLookupPath(), false, true);
+                    ofJson lookupJson = ofLoadJson(svo->getLookupPath());
+                    lookupJson["filename"] = svo->filename;
+                    lookupJson["path"] = svo->path;
+                    ofSaveJson(svo->getLookupPath(), lookupJson);
                 }
-               frames.push_back( Frame(frameIdx, timestamp) );
-               int repetitions = 0;
-               if (i > 0) {
-                   float millis = ofxZED::SVO::getDurationMillis(frames[i-1].timestamp, timestamp);
-                   float fpsMillis = 1000.0/fps;
-                   float effectiveFps = 1000.0/millis;
-                   repetitions =  round(millis/fpsMillis);
-                   for (auto _ = repetitions; _--;) lookup.push_back(i);
-               }
-
-               bool printProgress = false;
-
-               if (printProgress) {
-                string actualStr = ofToString(i)+"/"+ofToString(total);
-                std::cout.flush();
-                std::cout << "... lookup table: "+ofToString(lookup.size())+" "+actualStr+"";
-                std::cout.flush();
-               }
+                if (ofFile::doesFileExist(d->getPosesPath(), false)) ofFile::moveFromTo(d->getPosesPath(), svo->getPosesPath(), false, true);
+                if (d->hasPosesBinaryFile()) ofFile::moveFromTo(d->getPosesBinaryPath(), svo->getPosesBinaryPath(), false, true);
+                if (ofFile::doesFileExist(d->getCheckpointPath(), false)) ofFile::moveFromTo(d->getCheckpointPath(), svo->getCheckpointPath(), false, true);
+                d = svo;
             }
         }
+        manifest.erase(fromName);
+        if (poseIndex.rename(fromName, toName)) poseIndex.save(getPoseIndexPath());
+        write(directoryPath, databaseName);
+        publish();
+    }
+
+
+    /*-- long files can be split over several segment workers, see Scraper --*/
+
+    bool Database::scrape(SVO & svo, Camera & camera) {
+
+        static Histogram & scrapeTime = Metrics::histogram("svo.scrape");
+        static Counter & scrapedFrames = Metrics::counter("svo.scraped_frames");
+        static Gauge & scrapeRate = Metrics::gauge("svo.scrape_fps");
+
+        float t = ofGetElapsedTimef();
+        bool success;
+        {
+            ScopedTimer timer(scrapeTime);
+            OFXZED_TRACE("SVO::scrape");
+            if (segments > 1) {
+                camera.close();
+                success = svo.scrapeSegments(segments);
+            } else {
+                success = svo.scrape(camera);
+            }
+        }
+        float elapsed = std::max(ofGetElapsedTimef() - t, 0.001f);
+        int scraped = std::max(0, svo.getTotalFrames() - svo.resumedFrames);
+        scrapedFrames.add(scraped);
+        scrapeRate.set(scraped / elapsed);
+        return success;
+    }
+
+    /*-- each worker owns a Camera, so several SVOs can be scraped side by side --*/
 
+    void Database::processFiles(vector<ofFile> files, bool withLookup) {
+
+        startTime = ofGetElapsedTimef();
+        failed.clear();
+
+        int count = std::min(std::max(1, workers), (int)files.size());
+        if (count <= 1) {
+            for (auto & f : files) process(f, withLookup, zed);
+            if (zed.isOpened()) zed.close();
+            return;
+        }
 
+        ofLogNotice("ofxZED::Database") << "processing" << files.size() << "files with" << count << "workers";
+
+        std::atomic<int> next(0);
+        vector<std::thread> pool;
+        for (int i = 0; i < count; i++) {
+            pool.emplace_back([&]() {
+                Camera camera;
+                int idx;
+                while ((idx = next++) < files.size()) process(files[idx], withLookup, camera);
+                if (camera.isOpened()) camera.close();
+            });
+        }
+        for (auto & t : pool) t.join();
     }
 
-    void Database::process(ofFile & f, bool withLookup) {
+    void Database::process(ofFile & f, bool withLookup, Camera & camera) {
+
+        static Histogram & processTime = Metrics::histogram("database.process");
+        static Gauge & fileCount = Metrics::gauge("database.files");
+        ScopedTimer timer(processTime);
+        OFXZED_TRACE("Database::process");
 
         bool recreateLookups = false;
+        bool isFailed = false;
+        std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto entry = manifest.find(f.getFileName());
+        bool isInManifest = entry != manifest.end() && !isForcingRecreate;
+        std::shared_ptr<SVO> manifestEntry = isInManifest ? entry->second : nullptr;
+        lock.unlock();
+
+        if (isInManifest && manifestEntry->hasChanged()) {
+            ofLogNotice("ofxZED::Database") << f.getFileName() << "changed on disk, rescraping";
+            isInManifest = false;
+        }
+
+        /*-- the manifest's handle may already be published (ie. by loadFast), so it is copied, not scraped into --*/
 
+        if (isInManifest) svo->init(*manifestEntry, f.getAbsolutePath());
 
-        if (json["files"].find(f.getFileName()) != json["files"].end() && !isForcingRecreate) {
+        if (isInManifest) {
 
             ofLogNotice("ofxZED::Database") << "loading svo entry with lookup:" << withLookup;
 
-            SVO svo;
-            svo.init(json["files"][f.getFileName()]);
-            data.push_back(svo);
-            string lookupPath = data.back().getLookupPath();
+            string lookupPath = svo->getLookupPath();
             ofFile file(lookupPath);
             bool hasLookup = file.exists();
-            if (!hasLookup && withLookup) {
+            if ((!hasLookup && withLookup) || !svo->isComplete) {
 
 
 
-                ofLogNotice("ofxZED::Database") << "lookup table not found, creating new..." << svo.getLookupPath();
-                recreateLookups = true;
-                if (zed.openSVO(f.getAbsolutePath())) {
-                    ofLogNotice("ofxZED::Database") << "creating lookup table for entry" << svo.getLookupPath();
-                    data.back().scrape(zed);
+                ofLogNotice("ofxZED::Database") << "lookup table not found or partial, creating new..." << svo->getLookupPath();
+                if (camera.openSVO(f.getAbsolutePath())) {
+                    ofLogNotice("ofxZED::Database") << "creating lookup table for entry" << svo->getLookupPath();
+                    scrape(*svo, camera);
+                    recreateLookups = true;
                 } else {
                     ofLogError("ofxZED::Database") << "could not open" << f.getAbsolutePath();
-                    OF_EXIT_APP(0);
+                    isFailed = true;
                 }
             } else if (withLookup) {
 
-                ofLogNotice("ofxZED::Database") << "loading lookup table" << svo.getLookupPath();
+                ofLogNotice("ofxZED::Database") << "loading lookup table" << svo->getLookupPath();
 
-                svo.loadLookup();
+                svo->loadLookup();
             }
 
+            lock.lock();
+            data.push_back(svo);
+            if (recreateLookups) write(directoryPath, databaseName);
 
         } else {
 
@@ -186,30 +467,50 @@ namespace ofxZED {
            ofLogNotice("ofxZED::Database") << "creating database entry from scratch";
 
 
-            if (zed.openSVO(f.getAbsolutePath())) {
+            if (camera.openSVO(f.getAbsolutePath())) {
 
-                SVO svo;
-                svo.init(f, zed.getCameraFPS());
-                svo.scrape(zed);
-                svo.printInfo();
-                data.push_back(svo);
-                totalFrames += svo.getTotalFrames();
+                svo->init(f, camera.getCameraFPS());
+                if (isForcingRecreate) svo->removeCheckpoint();
+                scrape(*svo, camera);
+                svo->printInfo();
                 recreateLookups = true;
 
             } else {
                 ofLogError("ofxZED::Database") << "could not open" << f.getAbsolutePath();
-                OF_EXIT_APP(0);
+                isFailed = true;
             }
 
-
-            write(directoryPath, databaseName);
+            lock.lock();
+            if (!isFailed) {
+                data.push_back(svo);
+                totalFrames += svo->getTotalFrames();
+                write(directoryPath, databaseName);
+            }
         }
 
+        if (isFailed) failed.push_back(f.getAbsolutePath());
+        currIndex += 1;
+
+        Progress progress;
+        progress.filename = f.getFileName();
+        progress.file = currIndex;
+        progress.total = totalFiles;
+        progress.frames = totalFrames;
+        progress.failed = failed.size();
+        progress.elapsed = ofGetElapsedTimef() - startTime;
+        fileCount.set(data.size());
+        lock.unlock();
+
         if (recreateLookups) {
-            ofJson lookupJson = data.back().getJson(true);
-            ofSaveJson(data.back().getLookupPath(), lookupJson);
+            ofJson lookupJson = svo->getJson(true);
+            ofSaveJson(svo->getLookupPath(), lookupJson);
+            if (svo->isComplete) svo->removeCheckpoint();
         }
-        currIndex += 1;
+
+        /*-- workers finish side by side, listeners are still called one at a time --*/
+
+        std::unique_lock<std::mutex> progressLock(progressMutex);
+        ofNotifyEvent(progressEvent, progress, this);
 
 
     }
@@ -218,48 +519,467 @@ namespace ofxZED {
 
         float ts = ofGetElapsedTimef();
 
-        string csv = "Filename,Path,FPS,Timestamps,Lookup\n";
+        /*-- per-frame tables are written separately by Exporter --*/
 
+        string savePath = ofFilePath::join(dirPath, dbName);
+        std::ofstream csv(ofToDataPath(savePath + ".csv"), std::ios::binary);
+        csv << "Filename,Path,FPS\n";
 
-        ofSort(data, SVO::sortSVO);
-        for ( auto & d : data) {
-            json["files"][d.filename] = d.getJson(false);
-            csv += d.getCSV();
-        }
+        ofSort(data, SVO::sortSVOHandles);
+        for ( auto & d : data) csv << d->getCSV();
 
-        ofBuffer buff;
-        buff.set(csv.c_str(), csv.size());
-        string savePath = ofFilePath::join(dirPath, dbName);
-        ofSaveJson(savePath + ".json" , json);
-        ofBufferToFile(savePath + ".csv", buff);
+        if (!writeBinary(savePath + ".bin")) ofLogError("ofxZED::Database") << "manifest not updated, keeping" << savePath << ".bin";
+        if (withJsonManifest) exportJson(savePath + ".json");
 
         ofLogNotice("ofxZED::Database") << "writing db took" << ofGetElapsedTimef() - ts << "seconds to" << savePath;
 
     }
 
 
-    vector<SVO *> Database::getFilteredByRange( uint64_t start, uint64_t end) {
+    /*-- the binary manifest is preferred, an older .json one is imported once and replaced on the next write --*/
 
-        if (data.size() <= 0) {
-            ofLogError("ofxZED::Database") << "database is not loaded or is empty";
+    void Database::readManifest(string loadPath) {
+
+        static Histogram & readTime = Metrics::histogram("database.read_manifest");
+        ScopedTimer timer(readTime);
+        OFXZED_TRACE("Database::readManifest");
+
+        float ts = ofGetElapsedTimef();
+        vector<std::shared_ptr<SVO>> entries;
+        manifest.clear();
+
+        if (ofFile::doesFileExist(loadPath + ".bin", false)) {
+            if (!readBinary(loadPath + ".bin", entries)) importJson(loadPath + ".json", entries);
+        } else if (ofFile::doesFileExist(loadPath + ".json", false)) {
+            importJson(loadPath + ".json", entries);
         }
+        for (auto & entry : entries) manifest[entry->filename] = entry;
+        ofLogNotice("ofxZED::Database") << "read" << manifest.size() << "manifest entries in" << ofGetElapsedTimef() - ts << "seconds";
+    }
 
-        typedef std::chrono::system_clock::time_point time_point;
-        typedef ofxZED::SVO S;
-        string format = "%H:%M";
-        vector<SVO *> db;
-        for (auto & d : data) {
+    /*-- manifest fields of an SVO only, per-frame tables stay in the .lookup sidecar, the
+     * archive functions live here so only this file needs cereal --*/
+
+    template<class Archive> void save(Archive & ar, const SVO & svo, const std::uint32_t version) {
+        uint64_t start = (svo.frames.size() > 0) ? svo.frames.front().timestamp : 0;
+        uint64_t end = (svo.frames.size() > 0) ? svo.frames.back().timestamp : 0;
+        ar(svo.filename, svo.path, svo.fps, svo.isComplete, svo.fileSize, svo.fileModified, start, end);
+    }
+
+    /*-- entries from a newer manifest are refused rather than misread, the manifest is then
+     * imported from its .json or rebuilt, readBinary only loads into fresh SVOs --*/
 
+    template<class Archive> void load(Archive & ar, SVO & svo, const std::uint32_t version) {
+        if (version != 1) throw cereal::Exception("unknown SVO manifest entry version " + std::to_string(version));
+        uint64_t start, end;
+        ar(svo.filename, svo.path, svo.fps, svo.isComplete, svo.fileSize, svo.fileModified, start, end);
+        svo.frames.clear();
+        svo.frames.push_back( Frame(0, start) );
+        svo.frames.push_back( Frame(1, end) );
+    }
 
-            bool hasStartIn = (d.getStart() >= start  && d.getStart() <= end);
-            bool hasEndIn = (d.getEnd() >= start && d.getEnd() <= end);
-            bool hasWrapped = (d.getStart() < start  && d.getEnd() > end);
-            if (hasStartIn || hasEndIn || hasWrapped) {
-                db.push_back(&d);
+    /*-- written to a temporary file first, a crash never leaves a torn manifest --*/
+
+    bool Database::writeBinary(string path) {
+
+        string tmpPath = ofToDataPath(path + ".tmp");
+        bool written = false;
+        try {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            {
+                cereal::BinaryOutputArchive ar(out);
+                string magic = "ofxZED::Database";
+                uint32_t version = 1;
+                uint64_t count = data.size();
+                ar(magic, version, count);
+                for (auto & d : data) ar(*d);
             }
+            out.close();
+            written = !out.fail();
+            if (!written) ofLogError("ofxZED::Database") << "could not write" << tmpPath;
+        } catch (std::exception & e) {
+            ofLogError("ofxZED::Database") << "could not write" << path << e.what();
         }
-        return db;
 
+        if (written && std::rename(tmpPath.c_str(), ofToDataPath(path).c_str()) != 0) {
+            ofLogError("ofxZED::Database") << "could not replace" << path << strerror(errno);
+            written = false;
+        }
+        if (!written) std::remove(tmpPath.c_str());
+        return written;
+    }
+
+    bool Database::readBinary(string path, vector<std::shared_ptr<SVO>> & entries) {
+
+        entries.clear();
+        try {
+            std::ifstream in(ofToDataPath(path), std::ios::binary);
+            cereal::BinaryInputArchive ar(in);
+            string magic;
+            uint32_t version = 0;
+            uint64_t count = 0;
+            ar(magic, version, count);
+            if (magic != "ofxZED::Database" || version != 1) {
+                ofLogError("ofxZED::Database") << "unknown manifest" << path << magic << version;
+                return false;
+            }
+            entries.reserve(count);
+            for (uint64_t i = 0; i < count; i++) {
+                std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+                ar(*svo);
+                entries.push_back(svo);
+            }
+        } catch (std::exception & e) {
+            ofLogError("ofxZED::Database") << "could not read" << path << e.what();
+            entries.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool Database::exportJson(string path) {
+        ofJson j;
+        for (auto & d : data) j["files"][d->filename] = d->getJson(false);
+        return ofSaveJson(path, j);
+    }
+
+    bool Database::importJson(string path, vector<std::shared_ptr<SVO>> & entries) {
+        entries.clear();
+        ofJson j = ofLoadJson(path);
+        if (!j.is_object() || j.find("files") == j.end()) return false;
+        for (auto & entry : j["files"]) {
+            std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+            svo->init(entry);
+            entries.push_back(svo);
+        }
+        ofLogNotice("ofxZED::Database") << "imported" << entries.size() << "entries from" << path;
+        return true;
+    }
+
+    /*-- checks every entry against its sidecar and SVO frame count, one Camera per worker --*/
+
+    ofJson Database::verify(bool repair, bool withFrameCount) {
+
+        float ts = ofGetElapsedTimef();
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> current = getSnapshot();
+        const vector<std::shared_ptr<SVO>> & entries = *current;
+        vector<ofJson> results(entries.size());
+
+        int count = std::min(std::max(1, workers), std::max(1, (int)entries.size()));
+        std::atomic<int> next(0);
+        vector<std::thread> pool;
+        for (int i = 0; i < count; i++) {
+            pool.emplace_back([&]() {
+                Camera camera;
+                camera.init.depth_mode = sl::DEPTH_MODE_NONE;
+                int idx;
+                while ((idx = next++) < entries.size()) results[idx] = verifyEntry(*entries[idx], camera, repair, withFrameCount);
+                if (camera.isOpened()) camera.close();
+            });
+        }
+        for (auto & t : pool) t.join();
+
+        ofJson report;
+        int ok = 0, repaired = 0, withProblems = 0, failures = 0;
+        report["database"] = ofFilePath::join(directoryPath, databaseName);
+        for (auto & r : results) {
+            string status = r["status"].get<string>();
+            if (status == "ok") ok++;
+            if (status == "repaired") repaired++;
+            if (status == "problems") withProblems++;
+            if (status == "failed") failures++;
+            report["entries"].push_back(r);
+        }
+
+        ofDirectory d;
+        d.allowExt("svo");
+        d.listDir(directoryPath);
+        int unindexed = 0;
+        std::set<string> indexed;
+        for (auto & svo : entries) indexed.insert(svo->filename);
+        for (auto & f : d.getFiles()) {
+            if (indexed.find(f.getFileName()) == indexed.end()) {
+                report["unindexed"].push_back(f.getFileName());
+                unindexed++;
+            }
+        }
+
+        report["summary"]["entries"] = results.size();
+        report["summary"]["ok"] = ok;
+        report["summary"]["repaired"] = repaired;
+        report["summary"]["problems"] = withProblems;
+        report["summary"]["failed"] = failures;
+        report["summary"]["unindexed"] = unindexed;
+        report["summary"]["seconds"] = ofGetElapsedTimef() - ts;
+
+        if (repaired > 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            write(directoryPath, databaseName);
+            publish();
+        }
+
+        ofSaveJson(ofFilePath::join(directoryPath, databaseName + "_verify.json"), report);
+        ofLogNotice("ofxZED::Database") << "verified" << results.size() << "entries," << repaired << "repaired," << failures << "failed in" << ofGetElapsedTimef() - ts << "seconds";
+        return report;
+    }
+
+    ofJson Database::verifyEntry(SVO & entry, Camera & camera, bool repair, bool withFrameCount) {
+
+        ofJson r;
+        vector<string> problems;
+        bool isFailed = false;
+        bool isRepaired = false;
+        r["filename"] = entry.filename;
+
+        bool hasSVOFile = ofFile::doesFileExist(entry.getSVOPath(), false);
+        if (!hasSVOFile) {
+            problems.push_back("missing svo");
+            isFailed = true;
+        }
+
+        ofJson j;
+        bool hasLookup = entry.hasLookupFile();
+        if (hasLookup) j = ofLoadJson(entry.getLookupPath());
+        if (!hasLookup || j.is_null() || j["timestamps"].size() == 0) {
+            problems.push_back(hasLookup ? "unreadable lookup" : "missing lookup");
+            r["status"] = "failed";
+            r["problems"] = problems;
+            return r;
+        }
+        SVO svo;
+        svo.init(j);
+        if (j.value("lookupVersion", 1) < SVO::LOOKUP_VERSION) problems.push_back("old lookup format");
+
+        /*-- tables --*/
+
+        int duplicates = 0, backwards = 0;
+        for (int i = 1; i < svo.frames.size(); i++) {
+            if (svo.frames[i].timestamp == svo.frames[i-1].timestamp) duplicates++;
+            if (svo.frames[i].timestamp < svo.frames[i-1].timestamp) backwards++;
+        }
+        if (duplicates > 0) problems.push_back("duplicate timestamps: " + ofToString(duplicates));
+        if (backwards > 0) problems.push_back("non-monotonic timestamps: " + ofToString(backwards));
+        if (svo.getStart() != entry.getStart() || svo.getEnd() != entry.getEnd()) problems.push_back("manifest range differs from lookup");
+
+        vector<int> stored;
+        for (int i = 0; i < svo.getLookupLength(); i++) stored.push_back(svo.getLookupIndex(i));
+        if (repair && (duplicates > 0 || backwards > 0)) svo.repairTimestamps();
+        svo.buildLookup();
+        bool lookupDiffers = (stored.size() != svo.getLookupLength());
+        for (int i = 0; !lookupDiffers && i < stored.size(); i++) lookupDiffers = (stored[i] != svo.getLookupIndex(i));
+        if (lookupDiffers) problems.push_back("lookup does not match timestamps");
+
+        /*-- against the SVO itself --*/
+
+        int svoFrames = -1;
+        if (withFrameCount && hasSVOFile && camera.openSVO(entry.getSVOPath())) {
+            svoFrames = camera.getSVONumberOfFrames();
+            camera.close();
+        }
+        bool isTruncated = (svoFrames >= 0 && svo.getTotalFrames() < svoFrames);
+        if (isTruncated) problems.push_back("truncated: " + ofToString(svo.getTotalFrames()) + " of " + ofToString(svoFrames) + " frames");
+        if (svoFrames >= 0 && svo.getTotalFrames() > svoFrames) {
+            problems.push_back("more frames than svo: " + ofToString(svo.getTotalFrames()) + " of " + ofToString(svoFrames));
+            isFailed = true;
+        }
+        if (!svo.isComplete) problems.push_back("partial");
+
+        /*-- repair: fixed timestamps and lookups are saved, truncated tables resume on next build --*/
+
+        if (repair && !isFailed && problems.size() > 0) {
+            if (isTruncated) {
+                svo.isComplete = false;
+                svo.saveCheckpoint(0);
+            }
+            ofJson repairedJson = svo.getJson(true);
+            ofSaveJson(svo.getLookupPath(), repairedJson);
+
+            /*-- a fresh handle replaces the entry, snapshot readers keep the one they hold --*/
+
+            std::shared_ptr<SVO> repaired = std::make_shared<SVO>();
+            repaired->fileSize = entry.fileSize;
+            repaired->fileModified = entry.fileModified;
+            repaired->init(repairedJson);
+            if (!entry.hasTables()) repaired->releaseTables();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            for (auto & d : data) if (d.get() == &entry) d = repaired;
+            isRepaired = true;
+        }
+
+        r["frames"] = svo.getTotalFrames();
+        r["svoFrames"] = svoFrames;
+        r["problems"] = problems;
+        r["status"] = isFailed ? "failed" : (isRepaired ? "repaired" : (problems.empty() ? "ok" : "problems"));
+        return r;
+    }
+
+    /*-- builds this database from parent entries, reusing their tables instead of rescraping --*/
+
+    void Database::derive(vector<SVO *> entries, string location, string fileName, LinkMode mode) {
+
+        float ts = ofGetElapsedTimef();
+        ofDirectory::createDirectory(location, false, true);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        dir.open(location);
+        directoryPath = dir.getAbsolutePath();
+        databaseName = fileName;
+        isForcingRecreate = false;
+        manifest.clear();
+        data.clear();
+        totalFrames = 0;
+
+        for (auto & parent : entries) {
+
+            string svoPath = ofFilePath::join(directoryPath, parent->filename);
+            if (!placeFile(parent->getSVOPath(), svoPath, mode)) {
+                ofLogError("ofxZED::Database") << "could not place" << parent->filename;
+                continue;
+            }
+
+            /*-- tables come from the parent, rewritten for the new path --*/
+
+            parent->checkForLookup();
+            std::shared_ptr<SVO> svo = std::make_shared<SVO>();
+            svo->init(*parent, svoPath);
+            if (ofFile::doesFileExist(parent->getPosesPath(), false)) placeFile(parent->getPosesPath(), svo->getPosesPath(), mode);
+            if (parent->hasPosesBinaryFile()) placeFile(parent->getPosesBinaryPath(), svo->getPosesBinaryPath(), mode);
+            if (svo->getLookupLength() > 0) ofSaveJson(svo->getLookupPath(), svo->getJson(true));
+
+            totalFrames += svo->getTotalFrames();
+            data.push_back(svo);
+        }
+
+        totalFiles = data.size();
+        ofSort(data, SVO::sortSVOHandles);
+        write(directoryPath, databaseName);
+        publish();
+
+        ofLogNotice("ofxZED::Database") << "derived" << data.size() << "entries in" << ofGetElapsedTimef() - ts << "seconds to" << directoryPath;
+    }
+
+    /*-- hardlinks fail across filesystems, reflinks need CoW filesystems, symlinks always work locally --*/
+
+    /*-- the folder is resolved but not the file itself, so a symbolic link keeps its own location --*/
+
+    static string getCanonicalPath(string path) {
+        string folder = ofFilePath::getEnclosingDirectory(path, false);
+#ifdef TARGET_LINUX
+        char resolved[PATH_MAX];
+        if (realpath(folder.c_str(), resolved) != nullptr) folder = resolved;
+#endif
+        return ofFilePath::join(folder, ofFilePath::getFileName(path, false));
+    }
+
+    /*-- the same file or a hard or symbolic link to it --*/
+
+    static bool isSameFile(string a, string b) {
+#ifdef TARGET_LINUX
+        struct stat sa, sb;
+        if (stat(a.c_str(), &sa) != 0 || stat(b.c_str(), &sb) != 0) return false;
+        return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+#else
+        return getCanonicalPath(a) == getCanonicalPath(b);
+#endif
+    }
+
+    static bool linkFile(string from, string to, LinkMode mode) {
+#ifdef TARGET_LINUX
+        if (mode == LINK_AUTO || mode == LINK_HARD) {
+            if (link(from.c_str(), to.c_str()) == 0) return true;
+            if (mode == LINK_HARD) return false;
+        }
+        if (mode == LINK_AUTO || mode == LINK_REFLINK) {
+            int src = ::open(from.c_str(), O_RDONLY);
+            int dst = (src >= 0) ? ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+            bool cloned = (dst >= 0 && ioctl(dst, FICLONE, src) == 0);
+            if (src >= 0) ::close(src);
+            if (dst >= 0) ::close(dst);
+            if (cloned) return true;
+            if (dst >= 0) ::unlink(to.c_str());
+            if (mode == LINK_REFLINK) return false;
+        }
+        if (mode == LINK_AUTO || mode == LINK_SYMBOLIC) {
+            if (symlink(ofFilePath::getAbsolutePath(from).c_str(), to.c_str()) == 0) return true;
+            if (mode == LINK_SYMBOLIC) return false;
+        }
+#endif
+        ofLogNotice("ofxZED::Database") << "copying" << from;
+        return ofFile::copyFromTo(from, to, false, true);
+    }
+
+    /*-- never deletes anything but its own temporary, an existing target is kept when it already
+     * links to from and refused otherwise, so deriving into the parent's folder loses nothing --*/
+
+    bool Database::placeFile(string from, string to, LinkMode mode) {
+
+        if (ofFile::doesFileExist(to, false)) {
+            if (getCanonicalPath(from) == getCanonicalPath(to)) {
+                ofLogError("ofxZED::Database") << "not placing" << from << "onto itself";
+                return false;
+            }
+            if (isSameFile(from, to)) return true;
+            ofLogError("ofxZED::Database") << "not replacing" << to << ", it is not a link to" << from;
+            return false;
+        }
+
+        /*-- linked or copied under a temporary name, then renamed into place --*/
+
+        string tmpPath = to + ".tmp";
+        std::remove(tmpPath.c_str());
+        if (!linkFile(from, tmpPath, mode)) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        if (std::rename(tmpPath.c_str(), to.c_str()) != 0) {
+            ofLogError("ofxZED::Database") << "could not place" << to << strerror(errno);
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t Database::getStart() {
+        uint64_t start = 0;
+        for (auto & d : *getSnapshot()) if (start == 0 || d->getStart() < start) start = d->getStart();
+        return start;
+    }
+
+    uint64_t Database::getEnd() {
+        uint64_t end = 0;
+        for (auto & d : *getSnapshot()) if (d->getEnd() > end) end = d->getEnd();
+        return end;
+    }
+
+    vector<std::shared_ptr<SVO>> Database::getHandles() {
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> current = getSnapshot();
+        vector<std::shared_ptr<SVO>> handles(current->begin(), current->end());
+        ofSort(handles, SVO::sortSVOHandles);
+        return handles;
+    }
+
+    vector<std::shared_ptr<SVO>> Database::getHandlesInRange(uint64_t start, uint64_t end) {
+
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> current = getSnapshot();
+        if (current->size() <= 0) {
+            ofLogError("ofxZED::Database") << "database is not loaded or is empty";
+        }
+
+        vector<std::shared_ptr<SVO>> handles;
+        for (auto & d : *current) {
+            bool hasStartIn = (d->getStart() >= start  && d->getStart() <= end);
+            bool hasEndIn = (d->getEnd() >= start && d->getEnd() <= end);
+            bool hasWrapped = (d->getStart() < start  && d->getEnd() > end);
+            if (hasStartIn || hasEndIn || hasWrapped) handles.push_back(d);
+        }
+        return handles;
+    }
+
+    vector<SVO *> Database::getFilteredByRange( uint64_t start, uint64_t end) {
+        vector<SVO *> db;
+        for (auto & d : getHandlesInRange(start, end)) db.push_back(d.get());
+        return db;
     }
 
     std::map<string, vector<SVO *>> Database::getSortedByDay(vector<SVO *> svos) {
@@ -284,15 +1004,22 @@ namespace ofxZED {
     }
     vector<SVO *> Database::getPtrs() {
         vector<SVO *> db;
-        for (auto & d : data) db.push_back(&d);
-        ofSort(db, ofxZED::SVO::sortSVOPtrs);
+        for (auto & d : getHandles()) db.push_back(d.get());
         return db;
     }
 
+    vector<vector<PosePerson>> Database::getPosesAt(vector<SVO *> svos, uint64_t time) {
+        vector<vector<PosePerson>> out(svos.size());
+        for (int i = 0; i < svos.size(); i++) {
+            if (time >= svos[i]->getStart() && time <= svos[i]->getEnd()) out[i] = svos[i]->getPosesAt(time);
+        }
+        return out;
+    }
+
     vector<SVO *> Database::getPtrsInsideTimestamp(uint64_t time) {
         vector<SVO *> db;
 //        int DIV = 1000000000;
-        for (auto & d : data) if (time >= d.getStart() && time < d.getEnd() ) db.push_back(&d);
+        for (auto & d : *getSnapshot()) if (time >= d->getStart() && time < d->getEnd() ) db.push_back(d.get());
         return db;
     }
 
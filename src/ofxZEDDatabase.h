@@ -3,10 +3,34 @@
 #include "ofMain.h"
 #include "ofxZEDSVO.h"
 #include "ofxZEDCamera.h"
+#include "ofxZEDPoseIndex.h"
 
 
 namespace ofxZED {
 
+    /*-- how derived databases place their files, LINK_AUTO tries each in order --*/
+
+    enum LinkMode {
+        LINK_AUTO,
+        LINK_HARD,
+        LINK_REFLINK,
+        LINK_SYMBOLIC,
+        LINK_COPY
+    };
+
+    /*-- progress of build() / load(), notified from whichever thread finished the file,
+     * never from two at once, so listeners need no lock of their own --*/
+
+    struct Progress {
+    public:
+        string filename;
+        int file;
+        int total;
+        int frames;
+        int failed;
+        float elapsed;
+    };
+
     class Database {
     private:
 
@@ -16,29 +40,110 @@ namespace ofxZED {
         string databaseName;
         ofDirectory dir;
         int currIndex;
+        float startTime;
+
+        std::mutex mutex;
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> snapshot;
+        std::thread validator;
+        std::map<string, std::shared_ptr<SVO>> manifest;
+        void readManifest(string loadPath);
+        std::mutex zedMutex;
+        std::mutex progressMutex;
+        std::atomic<bool> stopValidating;
 
         void finish();
-        void scrape(ofFile & f, vector<Frame> & frames, vector<int> & lookup);
-        void process(ofFile & f, bool withLookup);
+        void publish();
+        bool scrape(SVO & svo, Camera & camera);
+        ofJson verifyEntry(SVO & entry, Camera & camera, bool repair, bool withFrameCount);
+        void processFiles(vector<ofFile> files, bool withLookup);
+        void process(ofFile & f, bool withLookup, Camera & camera);
     public:
 
         bool isForcingRecreate;
+        int workers;
+        int segments;
+        bool withPoseIndex;
+        PoseIndex poseIndex;
+        vector<string> failed;
+        vector<string> missing;
+        std::atomic<bool> isValidating;
+        ofEvent<Progress> progressEvent;
         int totalFiles;
         int totalFrames;
-        vector<SVO> data;
-        ofJson json;
+        vector<std::shared_ptr<SVO>> data;
+        bool withJsonManifest;
         string csv;
-        Database() { };
+        Database() { workers = 1; segments = 1; withPoseIndex = false; withJsonManifest = false; isValidating = false; stopValidating = false; };
+        ~Database();
 
         void build(string location, string fileName = "_database", bool withLookup = false, bool forceRecreate = false);
         void load(string databaseLocation, string databaseName, bool withLookup);
+        void loadManifest(string location, string fileName = "_database");
+
+        /*-- opens from the manifest alone, then (optionally in the background) stats every file,
+         * rescraping only entries whose size or mtime changed and adding new files --*/
+
+        void loadFast(string location, string fileName = "_database", bool validateInBackground = true);
+        void validate();
+        void stopValidation();
+        /*-- <name>.bin (cereal) is the manifest, <name>.json is only imported when there is no .bin,
+         * and exported when withJsonManifest is set --*/
+
         void write(string dirPath, string dbName);
+        bool writeBinary(string path);
+        bool readBinary(string path, vector<std::shared_ptr<SVO>> & entries);
+        bool exportJson(string path);
+        bool importJson(string path, vector<std::shared_ptr<SVO>> & entries);
+
+        /*-- checks tables for monotonic, unique, complete timestamps and matching lookups,
+         * optionally repairing them, the report is also saved as <name>_verify.json --*/
+
+        ofJson verify(bool repair = false, bool withFrameCount = true);
+
+        /*-- builds this database from parent entries, reusing their tables instead of rescraping --*/
+
+        void derive(vector<SVO *> entries, string location, string fileName = "_database", LinkMode mode = LINK_AUTO);
+        static bool placeFile(string from, string to, LinkMode mode = LINK_AUTO);
+
+        /*-- person centers of every .svo.poses, saved as <name>_poses.idx and loaded with the database --*/
+
+        void buildPoseIndex();
+        bool loadPoseIndex();
+        string getPoseIndexPath();
+
+        string getDirectoryPath();
+        string getDatabaseName();
+
+        /*-- incremental updates (ie. from a Watcher), safe to call from a background thread --*/
+
+        bool updateEntry(string filePath);
+        void removeEntry(string fileName);
+        void renameEntry(string fromName, string toName);
+
+        /*-- immutable copy of data, republished after every build, load or update --*/
+
+        std::shared_ptr<const vector<std::shared_ptr<SVO>>> getSnapshot();
+
+        uint64_t getStart();
+        uint64_t getEnd();
+
+        /*-- sorted handles from the snapshot, they keep their SVOs alive across updates --*/
+
+        vector<std::shared_ptr<SVO>> getHandles();
+        vector<std::shared_ptr<SVO>> getHandlesInRange(uint64_t start, uint64_t end);
+
+        /*-- raw pointers into the snapshot: only valid until the entry is replaced or removed
+         * (updateEntry, removeEntry, the validator), so not while a Watcher or loadFast is running,
+         * hold getHandles() instead there --*/
 
         vector<SVO *> getFilteredByRange( uint64_t start, uint64_t end);
-        std::map<string, vector<SVO *>> getSortedByDay(vector<SVO *> svos);
-        std::map<string, vector<SVO *>> getSortedBySerialNumber(vector<SVO *> svos);
+        static std::map<string, vector<SVO *>> getSortedByDay(vector<SVO *> svos);
+        static std::map<string, vector<SVO *>> getSortedBySerialNumber(vector<SVO *> svos);
         vector<SVO *> getPtrs();
         vector<SVO *> getPtrsInsideTimestamp(uint64_t time);
+
+        /*-- poses of many SVOs at one instant, empty for SVOs that do not cover it --*/
+        static vector<vector<PosePerson>> getPosesAt(vector<SVO *> svos, uint64_t time);
     };
 
 
@@ -0,0 +1,169 @@
+#include "ofxZEDDepthStats.h"
+#include "ofxZEDMetrics.h"
+#include "ofxZEDTrace.h"
+
+
+namespace ofxZED {
+
+    ofJson DepthFrameStats::getJson() {
+        ofJson j;
+        j["frame"] = frame;
+        j["timestamp"] = timestamp;
+        j["samples"] = samples;
+        j["valid"] = validRatio;
+        j["min"] = min;
+        j["max"] = max;
+        j["mean"] = mean;
+        j["low"] = low;
+        j["median"] = median;
+        j["high"] = high;
+        j["near"] = nearDepth;
+        j["far"] = farDepth;
+        return j;
+    }
+
+    DepthStats::DepthStats() {
+        stride = 4;
+        bins = 256;
+        minDepth = 0.1;
+        maxDepth = 20;
+        lowPercentile = 0.02;
+        highPercentile = 0.98;
+        smoothing = 0.1;
+        history = 300;
+        reset();
+    }
+
+    void DepthStats::reset() {
+        frames.clear();
+        isSmoothed = false;
+        smoothNear = minDepth;
+        smoothFar = maxDepth;
+    }
+
+    DepthFrameStats DepthStats::update(const float * src, int w, int h, int step, int frame, uint64_t timestamp) {
+
+        static Histogram & updateTime = Metrics::histogram("depthstats.update");
+        ScopedTimer timer(updateTime);
+        OFXZED_TRACE("DepthStats::update");
+
+        int n = std::max(1, bins);
+        int s = std::max(1, stride);
+        float scale = n / (maxDepth - minDepth);
+        float lo = minDepth;
+        float hi = maxDepth;
+
+        counts.assign(n + 1, 0);
+        int cols = (w + s - 1) / s;
+        vector<int32_t> indices(cols);
+        int32_t * idx = indices.data();
+
+        float minV = std::numeric_limits<float>::max();
+        float maxV = 0;
+        double sum = 0;
+        int samples = 0;
+
+        for (int y = 0; y < h; y += s) {
+            const float * row = src + (size_t) y * step;
+
+            /*-- branchless: out of range and NaN land in the extra bucket n, which is not counted --*/
+
+            float rowMin = std::numeric_limits<float>::max();
+            float rowMax = 0;
+            float rowSum = 0;
+            for (int i = 0; i < cols; i++) {
+                float d = row[i * s];
+                bool valid = d >= lo && d <= hi;
+                float t = valid ? (d - lo) * scale : 0;
+                int32_t b = (int32_t) t;
+                b = b < n ? b : n - 1;
+                idx[i] = valid ? b : n;
+                rowMin = valid && d < rowMin ? d : rowMin;
+                rowMax = valid && d > rowMax ? d : rowMax;
+                rowSum += valid ? d : 0;
+            }
+            for (int i = 0; i < cols; i++) counts[idx[i]]++;
+
+            minV = std::min(minV, rowMin);
+            maxV = std::max(maxV, rowMax);
+            sum += rowSum;
+            samples += cols;
+        }
+
+        DepthFrameStats r;
+        r.frame = frame;
+        r.timestamp = timestamp;
+        r.samples = samples;
+        r.valid = samples - counts[n];
+        r.validRatio = (samples > 0) ? (float) r.valid / samples : 0;
+        r.histogram.assign(counts.begin(), counts.begin() + n);
+        r.min = (r.valid > 0) ? minV : 0;
+        r.max = (r.valid > 0) ? maxV : 0;
+        r.mean = (r.valid > 0) ? sum / r.valid : 0;
+        r.low = getPercentile(r, lowPercentile);
+        r.median = getPercentile(r, 0.5);
+        r.high = getPercentile(r, highPercentile);
+
+        /*-- frames without valid depth keep the previous range --*/
+
+        if (r.valid > 0) {
+            float a = isSmoothed ? ofClamp(smoothing, 0, 1) : 1;
+            smoothNear += (r.low - smoothNear) * a;
+            smoothFar += (r.high - smoothFar) * a;
+            isSmoothed = true;
+        }
+        r.nearDepth = smoothNear;
+        r.farDepth = smoothFar;
+
+        frames.push_back(r);
+        while ((int) frames.size() > std::max(1, history)) frames.pop_front();
+        return r;
+    }
+
+    float DepthStats::getPercentile(const DepthFrameStats & s, float p) {
+        if (s.valid <= 0 || s.histogram.size() == 0) return 0;
+        float width = (maxDepth - minDepth) / s.histogram.size();
+        float target = ofClamp(p, 0, 1) * s.valid;
+        uint64_t seen = 0;
+        for (int b = 0; b < s.histogram.size(); b++) {
+            uint32_t c = s.histogram[b];
+            if (c > 0 && seen + c >= target) {
+                float frac = (target - seen) / c;
+                return minDepth + (b + frac) * width;
+            }
+            seen += c;
+        }
+        return maxDepth;
+    }
+
+    DepthFrameStats DepthStats::getLatest() {
+        if (frames.size() == 0) return DepthFrameStats();
+        return frames.back();
+    }
+
+    /*-- newest first, a frame seen twice (ie. after a seek) returns its latest stats --*/
+
+    bool DepthStats::get(int frame, DepthFrameStats & s) {
+        for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+            if (it->frame == frame) {
+                s = *it;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    float DepthStats::getNear() {
+        return smoothNear;
+    }
+
+    float DepthStats::getFar() {
+        return smoothFar;
+    }
+
+    void DepthStats::applyRange(Colormap & colormap) {
+        colormap.setRange(smoothNear, smoothFar);
+    }
+
+
+}
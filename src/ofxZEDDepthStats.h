@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDColormap.h"
+
+/*
+
+DepthStats: per-frame depth histogram and percentiles, for automatic near/far ranges
+
+- reads every stride-th pixel of every stride-th row of a float depth measure
+- valid depths (finite, inside [minDepth, maxDepth]) are binned linearly into bins buckets
+- percentiles are interpolated inside their bucket, ie. accurate to (maxDepth - minDepth) / bins
+- near and far are the lowPercentile and highPercentile depths, smoothed over frames
+  by an exponential moving average so the range does not flicker
+- the last history frames stay queryable by frame number
+
+    ofxZED::DepthFrameStats s = stats.update(depths, w, h, w, frame, timestamp);
+    colormap.setRange(stats.getNear(), stats.getFar());
+
+**/
+
+
+namespace ofxZED {
+
+    struct DepthFrameStats {
+    public:
+        int frame = -1;
+        uint64_t timestamp = 0;
+        int samples = 0;
+        int valid = 0;
+        float validRatio = 0;
+        float min = 0;
+        float max = 0;
+        float mean = 0;
+        float low = 0;
+        float median = 0;
+        float high = 0;
+
+        /*-- smoothed range at this frame --*/
+        float nearDepth = 0;
+        float farDepth = 0;
+
+        vector<uint32_t> histogram;
+
+        ofJson getJson();
+    };
+
+    class DepthStats {
+    private:
+        vector<uint32_t> counts;
+        std::deque<DepthFrameStats> frames;
+        bool isSmoothed;
+        float smoothNear, smoothFar;
+    public:
+
+        int stride;
+        int bins;
+        float minDepth, maxDepth;
+        float lowPercentile, highPercentile;
+
+        /*-- weight of the newest frame in the moving average, 1 disables smoothing --*/
+        float smoothing;
+        int history;
+
+        DepthStats();
+
+        /*-- step in floats --*/
+        DepthFrameStats update(const float * src, int w, int h, int step, int frame = -1, uint64_t timestamp = 0);
+        void reset();
+
+        /*-- depth at a percentile of the valid samples of one frame --*/
+        float getPercentile(const DepthFrameStats & s, float p);
+
+        DepthFrameStats getLatest();
+        bool get(int frame, DepthFrameStats & s);
+
+        float getNear();
+        float getFar();
+        void applyRange(Colormap & colormap);
+    };
+
+
+}
@@ -0,0 +1,207 @@
+#include "ofxZEDExporter.h"
+
+
+namespace ofxZED {
+
+    Exporter::Exporter() {
+        bufferSize = 1 << 20;
+        rows = 0;
+    }
+
+    uint64_t Exporter::getRowsWritten() {
+        return rows;
+    }
+
+    bool Exporter::write(Database & db, string path, ExportFormat format) {
+        vector<std::shared_ptr<SVO>> handles = db.getHandles();
+        vector<SVO *> svos;
+        for (auto & d : handles) svos.push_back(d.get());
+        return write(svos, path, format);
+    }
+
+    bool Exporter::write(vector<SVO *> svos, string path, ExportFormat format) {
+
+        float ts = ofGetElapsedTimef();
+        rows = 0;
+        skipped.clear();
+
+        vector<SVO *> withTables;
+        for (auto & svo : svos) {
+            if (svo->hasTables() || svo->hasLookupFile()) {
+                withTables.push_back(svo);
+            } else {
+                skipped.push_back(svo->filename);
+            }
+        }
+        svos.swap(withTables);
+        int unlisted = skipped.size();
+
+        /*-- written to temporary files first, a failed export never replaces a previous one --*/
+
+        string tmpPath = ofToDataPath(path + ".tmp");
+        string filesTmpPath = ofToDataPath(path + ".files.csv.tmp");
+        out.open(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            ofLogError("ofxZED::Exporter") << "could not open" << tmpPath;
+            return false;
+        }
+
+        bool written = true;
+        if (format == EXPORT_CSV) written = writeCSV(svos, filesTmpPath);
+        if (format == EXPORT_BINARY) writeBinary(svos);
+
+        flush(true);
+        if (out.fail()) written = false;
+        out.close();
+        if (out.fail()) written = false;
+        chunk.clear();
+
+        if (written && std::rename(tmpPath.c_str(), ofToDataPath(path).c_str()) != 0) written = false;
+        if (written && format == EXPORT_CSV && std::rename(filesTmpPath.c_str(), ofToDataPath(path + ".files.csv").c_str()) != 0) written = false;
+        if (!written) {
+            ofLogError("ofxZED::Exporter") << "could not write" << path << strerror(errno);
+            std::remove(tmpPath.c_str());
+            std::remove(filesTmpPath.c_str());
+            return false;
+        }
+
+        ofLogNotice("ofxZED::Exporter") << "exported" << rows << "frames from" << svos.size() + unlisted - skipped.size() << "files in" << ofGetElapsedTimef() - ts << "seconds to" << path;
+        if (skipped.size() > 0) ofLogWarning("ofxZED::Exporter") << "skipped" << skipped.size() << "files without tables";
+        return true;
+    }
+
+    void Exporter::flush(bool force) {
+        if (chunk.size() < bufferSize && !force) return;
+        out.write(chunk.data(), chunk.size());
+        chunk.clear();
+    }
+
+    void Exporter::appendUInt(uint64_t value) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + (value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (n > 0) chunk += digits[--n];
+    }
+
+    void Exporter::appendInt(int64_t value) {
+        if (value < 0) {
+            chunk += '-';
+            appendUInt((uint64_t)(-(value + 1)) + 1);
+        } else {
+            appendUInt(value);
+        }
+    }
+
+    static string quote(const string & field) {
+        if (field.find_first_of(",\"\r\n") == string::npos) return field;
+        string quoted = "\"";
+        for (char c : field) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    bool Exporter::writeCSV(vector<SVO *> & svos, string filesPath) {
+
+        std::ofstream files(filesPath, std::ios::binary | std::ios::trunc);
+        files << "file,filename,path,fps\n";
+
+        chunk.reserve(bufferSize + 256);
+        chunk += "file,frame,timestamp,gap\n";
+
+        for (int id = 0; id < svos.size(); id++) {
+
+            SVO * svo = svos[id];
+            files << id << "," << quote(svo->filename) << "," << quote(svo->path) << "," << svo->fps << "\n";
+
+            bool wasLoaded = svo->hasTables();
+            svo->checkForLookup();
+            if (!svo->hasTables()) {
+                skipped.push_back(svo->filename);
+                continue;
+            }
+
+            uint64_t previous = 0;
+            for (int i = 0; i < svo->frames.size(); i++) {
+                uint64_t timestamp = svo->frames[i].timestamp;
+                appendUInt(id);
+                chunk += ',';
+                appendInt(svo->frames[i].frame);
+                chunk += ',';
+                appendUInt(timestamp);
+                chunk += ',';
+                appendInt((i == 0) ? 0 : (int64_t)(timestamp - previous));
+                chunk += '\n';
+                previous = timestamp;
+                flush();
+            }
+            rows += svo->frames.size();
+
+            if (!wasLoaded) svo->releaseTables();
+        }
+
+        files.close();
+        return !files.fail();
+    }
+
+    void Exporter::writeBinary(vector<SVO *> & svos) {
+
+        uint32_t version = 1;
+        uint32_t count = svos.size();
+        out.write("ZEDF", 4);
+        out.write((const char *) &version, sizeof(version));
+        out.write((const char *) &count, sizeof(count));
+
+        for (uint32_t id = 0; id < count; id++) {
+            uint32_t fps = svos[id]->fps;
+            uint16_t length = svos[id]->filename.size();
+            out.write((const char *) &id, sizeof(id));
+            out.write((const char *) &fps, sizeof(fps));
+            out.write((const char *) &length, sizeof(length));
+            out.write(svos[id]->filename.data(), length);
+        }
+
+        vector<int32_t> frameColumn;
+        vector<uint64_t> timestampColumn;
+        vector<int64_t> gapColumn;
+
+        for (uint32_t id = 0; id < count; id++) {
+
+            SVO * svo = svos[id];
+            bool wasLoaded = svo->hasTables();
+            svo->checkForLookup();
+            if (!svo->hasTables()) {
+                skipped.push_back(svo->filename);
+                continue;
+            }
+
+            uint32_t total = svo->frames.size();
+            frameColumn.resize(total);
+            timestampColumn.resize(total);
+            gapColumn.resize(total);
+            for (uint32_t i = 0; i < total; i++) {
+                frameColumn[i] = svo->frames[i].frame;
+                timestampColumn[i] = svo->frames[i].timestamp;
+                gapColumn[i] = (i == 0) ? 0 : (int64_t)(timestampColumn[i] - timestampColumn[i-1]);
+            }
+
+            out.write((const char *) &id, sizeof(id));
+            out.write((const char *) &total, sizeof(total));
+            out.write((const char *) frameColumn.data(), total * sizeof(int32_t));
+            out.write((const char *) timestampColumn.data(), total * sizeof(uint64_t));
+            out.write((const char *) gapColumn.data(), total * sizeof(int64_t));
+            rows += total;
+
+            if (!wasLoaded) svo->releaseTables();
+        }
+
+        uint32_t end = 0xFFFFFFFF;
+        out.write((const char *) &end, sizeof(end));
+    }
+
+
+}
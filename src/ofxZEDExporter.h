@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDSVO.h"
+#include "ofxZEDDatabase.h"
+
+/*
+
+Exporter: streams per-frame tables for a whole database, one row per frame
+
+EXPORT_CSV
+
+    file,frame,timestamp,gap
+    (plus <path>.files.csv with file,filename,path,fps)
+
+EXPORT_BINARY (little-endian, one column block per file)
+
+    char[4]  magic "ZEDF"
+    uint32   version
+    uint32   number of files
+    files    uint32 id, uint32 fps, uint16 name length, char[] filename
+    blocks   uint32 file id, uint32 rows, int32 frame[rows], uint64 timestamp[rows], int64 gap[rows]
+    uint32   0xFFFFFFFF end marker
+
+- gap is nanoseconds since the previous frame of the same file, 0 on the first frame
+- tables are paged in one SVO at a time and released again if they were not loaded before
+- SVOs without tables (no .lookup, only the manifest's first and last frame) are left out
+  and listed in skipped
+- csv fields holding commas, quotes or line breaks are quoted
+- files are written as <path>.tmp and renamed, write() returns false on any write error
+
+**/
+
+
+namespace ofxZED {
+
+    enum ExportFormat {
+        EXPORT_CSV,
+        EXPORT_BINARY
+    };
+
+    class Exporter {
+    private:
+
+        string chunk;
+        std::ofstream out;
+        uint64_t rows;
+
+        void flush(bool force = false);
+        void appendUInt(uint64_t value);
+        void appendInt(int64_t value);
+        bool writeCSV(vector<SVO *> & svos, string filesPath);
+        void writeBinary(vector<SVO *> & svos);
+
+    public:
+
+        size_t bufferSize;
+        vector<string> skipped;
+
+        Exporter();
+
+        bool write(Database & db, string path, ExportFormat format = EXPORT_CSV);
+        bool write(vector<SVO *> svos, string path, ExportFormat format = EXPORT_CSV);
+        uint64_t getRowsWritten();
+    };
+
+
+}
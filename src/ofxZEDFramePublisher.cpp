@@ -0,0 +1,276 @@
+#include "ofxZEDFramePublisher.h"
+
+#ifndef TARGET_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+
+namespace ofxZED {
+
+    static uint64_t align64(uint64_t n) {
+        return (n + 63) & ~(uint64_t) 63;
+    }
+
+#ifndef TARGET_WIN32
+
+    /*-- only a segment whose header names a publisher that no longer runs counts as stale,
+     * anything unreadable or half-initialised may still belong to a live one --*/
+
+    static bool isAbandoned(string name) {
+        int existing = shm_open(name.c_str(), O_RDONLY, 0);
+        if (existing < 0) return false;
+        struct stat st;
+        bool abandoned = false;
+        if (fstat(existing, &st) == 0 && st.st_size >= (off_t) sizeof(SharedRingHeader)) {
+            void * view = mmap(nullptr, sizeof(SharedRingHeader), PROT_READ, MAP_SHARED, existing, 0);
+            if (view != MAP_FAILED) {
+                const SharedRingHeader * h = (const SharedRingHeader *) view;
+                bool isRing = std::memcmp(h->magic, FrameRing::MAGIC, sizeof(h->magic)) == 0 && h->version == FrameRing::VERSION;
+                abandoned = isRing && h->owner > 0 && kill((pid_t) h->owner, 0) != 0 && errno == ESRCH;
+                munmap(view, sizeof(SharedRingHeader));
+            }
+        }
+        ::close(existing);
+        return abandoned;
+    }
+
+#endif
+
+    FramePublisher::FramePublisher() {
+        fd = -1;
+        mapped = nullptr;
+        mappedBytes = 0;
+        header = nullptr;
+        count = 0;
+    }
+
+    FramePublisher::~FramePublisher() {
+        close();
+    }
+
+    int FramePublisher::getBytesPerPixel(int format) {
+        if (format == FORMAT_RGB8) return 3;
+        if (format == FORMAT_RGBA8 || format == FORMAT_BGRA8 || format == FORMAT_FLOAT1) return 4;
+        if (format == FORMAT_FLOAT4) return 16;
+        return 0;
+    }
+
+    bool FramePublisher::open(string name_, int width, int height, int slots, bool withCloud, bool force) {
+
+        close();
+        name = FrameRing::getShmName(name_);
+
+#ifdef TARGET_WIN32
+        ofLogError("ofxZED::FramePublisher") << "shared frames need POSIX shared memory";
+        return false;
+#else
+        uint64_t pixels = (uint64_t) width * height;
+        uint64_t capacity[STREAM_COUNT] = { pixels * 4, pixels * 4, withCloud ? pixels * 16 : 0 };
+        uint64_t offset[STREAM_COUNT];
+        uint64_t slotBytes = align64(sizeof(SharedSlot));
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            offset[i] = slotBytes;
+            slotBytes += align64(capacity[i]);
+        }
+        slots = std::max(2, slots);
+        uint64_t totalBytes = align64(sizeof(SharedRingHeader)) + slotBytes * slots;
+
+        /*-- created exclusively, readable by this user and group only, an existing segment is
+         * only replaced when its publisher is gone or force is set --*/
+
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+        if (fd < 0 && errno == EEXIST) {
+            if (!force && !isAbandoned(name)) {
+                ofLogError("ofxZED::FramePublisher") << name << "is in use by another publisher, open with force to take it over";
+                return false;
+            }
+            ofLogNotice("ofxZED::FramePublisher") << "replacing" << (force ? "existing" : "abandoned") << "segment" << name;
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+        }
+        if (fd < 0 || ftruncate(fd, totalBytes) != 0) {
+            ofLogError("ofxZED::FramePublisher") << "could not create" << name << strerror(errno);
+            close();
+            return false;
+        }
+
+        mappedBytes = totalBytes;
+        mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            mapped = nullptr;
+            ofLogError("ofxZED::FramePublisher") << "could not map" << name << strerror(errno);
+            close();
+            return false;
+        }
+
+        /*-- the magic goes in last, so a reader never accepts a half-initialised segment --*/
+
+        header = new (mapped) SharedRingHeader();
+        std::memset(header->magic, 0, sizeof(header->magic));
+        header->version = FrameRing::VERSION;
+        header->slots = slots;
+        header->slotBytes = slotBytes;
+        header->totalBytes = totalBytes;
+        header->owner = getpid();
+        header->published.store(0);
+        for (int s = 0; s < slots; s++) {
+            SharedSlot * slot = new (FrameRing::getSlot(header, s)) SharedSlot();
+            slot->sequence.store(0);
+            slot->count = 0;
+            slot->frame = -1;
+            slot->timestamp = 0;
+            slot->svo[0] = 0;
+            for (int i = 0; i < STREAM_COUNT; i++) {
+                slot->streams[i] = SharedStreamInfo();
+                slot->streams[i].format = FORMAT_NONE;
+                slot->streams[i].offset = offset[i];
+                slot->streams[i].capacity = capacity[i];
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, FrameRing::MAGIC, sizeof(header->magic));
+
+        count = 0;
+        for (auto & w : warned) w = false;
+        ofLogNotice("ofxZED::FramePublisher") << "publishing" << width << "x" << height << "to" << name << "," << slots << "slots of" << (slotBytes >> 20) << "MB";
+        return true;
+#endif
+    }
+
+    void FramePublisher::close() {
+#ifndef TARGET_WIN32
+        if (mapped) munmap(mapped, mappedBytes);
+        if (fd >= 0) {
+
+            /*-- after a forced takeover the name belongs to the new publisher, leave it linked --*/
+
+            struct stat ours, current;
+            int existing = shm_open(name.c_str(), O_RDONLY, 0);
+            bool isOurs = existing >= 0 && fstat(fd, &ours) == 0 && fstat(existing, &current) == 0 && ours.st_ino == current.st_ino;
+            if (existing >= 0) ::close(existing);
+            if (isOurs) shm_unlink(name.c_str());
+            ::close(fd);
+        }
+#endif
+        mapped = nullptr;
+        mappedBytes = 0;
+        header = nullptr;
+        fd = -1;
+    }
+
+    bool FramePublisher::isOpen() {
+        return header != nullptr;
+    }
+
+    string FramePublisher::getName() {
+        return name;
+    }
+
+    bool FramePublisher::publish(int frame, uint64_t timestamp, string svo, const uint8_t * data[STREAM_COUNT], const SharedStreamInfo info[STREAM_COUNT]) {
+
+        static Histogram & publishTime = Metrics::histogram("publisher.publish");
+        static Counter & published = Metrics::counter("publisher.frames");
+        ScopedTimer timer(publishTime);
+        OFXZED_TRACE("FramePublisher::publish");
+
+        if (!header) return false;
+
+        /*-- seqlock: odd while writing, readers that saw the old even value will fail isValid() --*/
+
+        SharedSlot * slot = FrameRing::getSlot(header, count);
+        uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->count = count;
+        slot->frame = frame;
+        slot->timestamp = timestamp;
+        std::strncpy(slot->svo, svo.c_str(), sizeof(slot->svo) - 1);
+        slot->svo[sizeof(slot->svo) - 1] = 0;
+
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            SharedStreamInfo & out = slot->streams[i];
+            int bpp = getBytesPerPixel(info[i].format);
+            uint64_t rowBytes = (uint64_t) info[i].width * bpp;
+            uint64_t bytes = rowBytes * info[i].height;
+
+            out.format = FORMAT_NONE;
+            out.bytes = 0;
+            if (!data[i] || bpp == 0 || bytes == 0) continue;
+            if (bytes > out.capacity) {
+                if (!warned[i]) ofLogWarning("ofxZED::FramePublisher") << "stream" << i << "needs" << bytes << "bytes, slot holds" << out.capacity << ", skipping it";
+                warned[i] = true;
+                continue;
+            }
+
+            uint8_t * dst = (uint8_t *) slot + out.offset;
+            uint64_t step = (info[i].step > 0) ? info[i].step : rowBytes;
+            if (step == rowBytes) {
+                std::memcpy(dst, data[i], bytes);
+            } else {
+                for (int y = 0; y < info[i].height; y++) std::memcpy(dst + y * rowBytes, data[i] + y * step, rowBytes);
+            }
+            out.format = info[i].format;
+            out.width = info[i].width;
+            out.height = info[i].height;
+            out.step = rowBytes;
+            out.bytes = bytes;
+        }
+
+        slot->sequence.store(sequence + 2, std::memory_order_release);
+        header->published.store(count + 1, std::memory_order_release);
+        count++;
+        published.add();
+        return true;
+    }
+
+    bool FramePublisher::publish(Player & player) {
+
+        const uint8_t * data[STREAM_COUNT] = { nullptr, nullptr, nullptr };
+        SharedStreamInfo info[STREAM_COUNT];
+        for (auto & i : info) i = SharedStreamInfo();
+
+        if (player.left && player.leftPix.isAllocated()) {
+            ofPixels & pix = player.leftPix;
+            data[STREAM_LEFT] = pix.getData();
+            info[STREAM_LEFT].format = (pix.getNumChannels() == 4) ? FORMAT_BGRA8 : FORMAT_RGB8;
+            info[STREAM_LEFT].width = pix.getWidth();
+            info[STREAM_LEFT].height = pix.getHeight();
+        }
+
+        if (player.depth) {
+            if (player.measureDepth || player.autoRange) {
+                sl::Mat & mat = player.measureMat;
+                data[STREAM_DEPTH] = mat.getPtr<sl::uchar1>();
+                info[STREAM_DEPTH].format = FORMAT_FLOAT1;
+                info[STREAM_DEPTH].width = mat.getWidth();
+                info[STREAM_DEPTH].height = mat.getHeight();
+                info[STREAM_DEPTH].step = mat.getStepBytes();
+            } else if (player.depthPix.isAllocated()) {
+                ofPixels & pix = player.depthPix;
+                data[STREAM_DEPTH] = pix.getData();
+                info[STREAM_DEPTH].format = player.colorizeDepth ? FORMAT_RGBA8 : FORMAT_BGRA8;
+                info[STREAM_DEPTH].width = pix.getWidth();
+                info[STREAM_DEPTH].height = pix.getHeight();
+            }
+        }
+
+        if (player.cloud) {
+            sl::Mat & mat = player.cloudMat;
+            data[STREAM_CLOUD] = mat.getPtr<sl::uchar1>();
+            info[STREAM_CLOUD].format = FORMAT_FLOAT4;
+            info[STREAM_CLOUD].width = mat.getWidth();
+            info[STREAM_CLOUD].height = mat.getHeight();
+            info[STREAM_CLOUD].step = mat.getStepBytes();
+        }
+
+        string svo = (player.svo) ? player.svo->getName() : "";
+        return publish(player.getDisplayedFrame(), player.getFrameTimestamp(), svo, data, info);
+    }
+
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDFrameRing.h"
+#include "ofxZEDPlayer.h"
+
+/*
+
+FramePublisher: writes decoded Player frames into a FrameRing for other local processes
+
+- the segment is sized once in open() for a resolution, streams that do not fit are skipped
+- left is the left pixels, depth the float measure when the Player retrieves it (measureDepth
+  or autoRange) and the depth pixels otherwise, cloud the XYZRGBA measure
+- rows are packed (step is width * bytes per pixel) whatever the source step
+- the segment is created with O_EXCL and mode 0660 (the publisher's user and group), an existing
+  one with the same name is only replaced when the publisher pid in its header is no longer
+  running, or when open() is called with force (readers of the old one keep their view)
+- the segment is unlinked on close(), readers that still map it keep their view
+
+    ofxZED::FramePublisher publisher;
+    publisher.open("/ofxZED", player.getWidth(), player.getHeight());
+    if (player.grab()) publisher.publish(player);
+
+**/
+
+
+namespace ofxZED {
+
+    class FramePublisher {
+    private:
+        string name;
+        int fd;
+        void * mapped;
+        size_t mappedBytes;
+        SharedRingHeader * header;
+        uint64_t count;
+        bool warned[STREAM_COUNT];
+    public:
+
+        FramePublisher();
+        ~FramePublisher();
+
+        /*-- capacity per slot: width x height of RGBA8 left, float or RGBA8 depth and XYZRGBA cloud --*/
+        bool open(string name_, int width, int height, int slots = 4, bool withCloud = false, bool force = false);
+        void close();
+        bool isOpen();
+        string getName();
+
+        /*-- one frame, data and info per stream, nullptr data or FORMAT_NONE skips a stream --*/
+        bool publish(int frame, uint64_t timestamp, string svo, const uint8_t * data[STREAM_COUNT], const SharedStreamInfo info[STREAM_COUNT]);
+        bool publish(Player & player);
+
+        static int getBytesPerPixel(int format);
+    };
+
+
+}
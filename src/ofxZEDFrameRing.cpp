@@ -0,0 +1,151 @@
+#include "ofxZEDFrameRing.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace ofxZED {
+
+    const char * FrameRing::MAGIC = "ofxZEDFR";
+
+    std::string FrameRing::getShmName(std::string name) {
+        if (name.empty() || name[0] != '/') name = "/" + name;
+        return name;
+    }
+
+    SharedSlot * FrameRing::getSlot(SharedRingHeader * header, uint64_t i) {
+        uint8_t * base = (uint8_t *) header + sizeof(SharedRingHeader);
+        return (SharedSlot *) (base + (i % header->slots) * header->slotBytes);
+    }
+
+    /*-- FrameReader --*/
+
+    FrameReader::FrameReader() {
+        fd = -1;
+        mapped = nullptr;
+        mappedBytes = 0;
+        header = nullptr;
+    }
+
+    FrameReader::~FrameReader() {
+        close();
+    }
+
+    bool FrameReader::open(std::string name_) {
+        close();
+        name = FrameRing::getShmName(name_);
+
+#ifdef _WIN32
+        error = "shared frames need POSIX shared memory";
+        return false;
+#else
+        fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            error = "could not open " + name + ", is the publisher running?";
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SharedRingHeader)) {
+            error = "segment " + name + " is too small";
+            close();
+            return false;
+        }
+
+        mappedBytes = st.st_size;
+        mapped = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            mapped = nullptr;
+            error = "could not map " + name;
+            close();
+            return false;
+        }
+
+        header = (SharedRingHeader *) mapped;
+        if (std::memcmp(header->magic, FrameRing::MAGIC, 8) != 0 || header->version != FrameRing::VERSION) {
+            error = name + " is not a version " + std::to_string(FrameRing::VERSION) + " frame ring";
+            close();
+            return false;
+        }
+        if (header->totalBytes > mappedBytes || header->slots == 0) {
+            error = name + " is truncated";
+            close();
+            return false;
+        }
+
+        error = "";
+        return true;
+#endif
+    }
+
+    void FrameReader::close() {
+#ifndef _WIN32
+        if (mapped) munmap(mapped, mappedBytes);
+        if (fd >= 0) ::close(fd);
+#endif
+        mapped = nullptr;
+        mappedBytes = 0;
+        header = nullptr;
+        fd = -1;
+    }
+
+    bool FrameReader::isOpen() {
+        return header != nullptr;
+    }
+
+    uint64_t FrameReader::getPublished() {
+        if (!header) return 0;
+        return header->published.load(std::memory_order_acquire);
+    }
+
+    bool FrameReader::latest(SharedFrame & f) {
+
+        /*-- a writer lapping the whole ring while we read is unlikely, retry a few times --*/
+
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint64_t count = getPublished();
+            if (count == 0) return false;
+            if (read(count - 1, f)) return true;
+        }
+        return false;
+    }
+
+    bool FrameReader::read(uint64_t count, SharedFrame & f) {
+        if (!header || count >= getPublished()) return false;
+
+        const SharedSlot * slot = FrameRing::getSlot(header, count);
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) return false;
+
+        f.slot = slot;
+        f.sequence = sequence;
+        f.count = slot->count;
+        f.frame = slot->frame;
+        f.timestamp = slot->timestamp;
+        f.svo = std::string(slot->svo, strnlen(slot->svo, sizeof(slot->svo)));
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            f.streams[i] = slot->streams[i];
+            bool present = f.streams[i].format != FORMAT_NONE && f.streams[i].offset + f.streams[i].bytes <= header->slotBytes;
+            f.data[i] = present ? (const uint8_t *) slot + f.streams[i].offset : nullptr;
+        }
+
+        /*-- the metadata copy is only consistent if the sequence did not move --*/
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != sequence) return false;
+        return f.count == count;
+    }
+
+    bool FrameReader::isValid(const SharedFrame & f) {
+        if (!header || !f.slot) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return f.slot->sequence.load(std::memory_order_relaxed) == f.sequence;
+    }
+
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/*
+
+FrameRing: decoded frames shared with other local processes through POSIX shared memory
+
+- one segment (shm_open name, ie. "/ofxZED") holds a header and slots ring slots
+- each slot is a fixed size: its metadata, then the left, depth and cloud streams
+- the publisher writes slot (n % slots) for frame n under a seqlock: the slot sequence is odd
+  while it is written and even once complete, then the header's published count is bumped
+- readers take pointers straight into the segment (no copy) and call isValid() once they are
+  done, if the slot was rewritten meanwhile the frame must be dropped
+- a slot is only rewritten every slots frames, so a reader has that long to consume it
+
+This header and ofxZEDFrameRing.cpp only depend on the standard library and POSIX,
+so consumers can build the reader without openFrameworks or the ZED SDK.
+
+    ofxZED::FrameReader reader;
+    reader.open("/ofxZED");
+    ofxZED::SharedFrame f;
+    if (reader.latest(f)) {
+        use(f.left, f.streams[ofxZED::STREAM_LEFT]);
+        if (!reader.isValid(f)) discard();
+    }
+
+**/
+
+
+namespace ofxZED {
+
+    /*-- the seqlock and published count are shared between processes, a lock-based atomic
+     * would keep its lock in one process only --*/
+
+#if __cplusplus >= 201703L
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "FrameRing needs lock-free 64-bit atomics");
+#else
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2, "FrameRing needs lock-free 64-bit atomics");
+#endif
+
+    enum SharedStream {
+        STREAM_LEFT,
+        STREAM_DEPTH,
+        STREAM_CLOUD,
+        STREAM_COUNT
+    };
+
+    enum SharedFormat {
+        FORMAT_NONE,
+        FORMAT_RGB8,
+        FORMAT_RGBA8,
+        FORMAT_BGRA8,
+        FORMAT_FLOAT1,
+        FORMAT_FLOAT4
+    };
+
+    struct SharedStreamInfo {
+    public:
+        int32_t format;
+        int32_t width;
+        int32_t height;
+        uint32_t step;
+        uint64_t offset;
+        uint64_t capacity;
+        uint64_t bytes;
+    };
+
+    struct alignas(64) SharedSlot {
+    public:
+        std::atomic<uint64_t> sequence;
+        uint64_t count;
+        int32_t frame;
+        uint64_t timestamp;
+        char svo[256];
+        SharedStreamInfo streams[STREAM_COUNT];
+    };
+
+    struct alignas(64) SharedRingHeader {
+    public:
+        char magic[8];
+        uint32_t version;
+        uint32_t slots;
+        uint64_t slotBytes;
+        uint64_t totalBytes;
+
+        /*-- pid of the publishing process, a new publisher only replaces a segment whose owner is gone --*/
+        int64_t owner;
+        std::atomic<uint64_t> published;
+    };
+
+    struct SharedFrame {
+    public:
+        const SharedSlot * slot = nullptr;
+        uint64_t sequence = 0;
+        uint64_t count = 0;
+        int frame = -1;
+        uint64_t timestamp = 0;
+        std::string svo;
+        SharedStreamInfo streams[STREAM_COUNT];
+        const uint8_t * data[STREAM_COUNT] = { nullptr, nullptr, nullptr };
+    };
+
+    class FrameRing {
+    public:
+        static const uint32_t VERSION = 2;
+        static const char * MAGIC;
+
+        static std::string getShmName(std::string name);
+        static SharedSlot * getSlot(SharedRingHeader * header, uint64_t i);
+    };
+
+    class FrameReader {
+    private:
+        std::string name;
+        int fd;
+        void * mapped;
+        size_t mappedBytes;
+        SharedRingHeader * header;
+    public:
+
+        std::string error;
+
+        FrameReader();
+        ~FrameReader();
+
+        bool open(std::string name_);
+        void close();
+        bool isOpen();
+
+        /*-- frames published so far, ie. to poll for new ones --*/
+        uint64_t getPublished();
+
+        /*-- newest complete frame, false when none is published or the writer keeps overtaking --*/
+        bool latest(SharedFrame & f);
+
+        /*-- a specific frame count, false once its slot has been rewritten --*/
+        bool read(uint64_t count, SharedFrame & f);
+
+        /*-- true while the slot still holds the frame, check after using the pointers --*/
+        bool isValid(const SharedFrame & f);
+    };
+
+
+}
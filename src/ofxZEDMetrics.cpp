@@ -0,0 +1,189 @@
+#include "ofxZEDMetrics.h"
+
+
+namespace ofxZED {
+
+    std::mutex Metrics::mutex;
+    std::map<string, std::unique_ptr<Counter>> Metrics::counters;
+    std::map<string, std::unique_ptr<Gauge>> Metrics::gauges;
+    std::map<string, std::unique_ptr<Histogram>> Metrics::histograms;
+    MetricsDumper Metrics::dumper;
+    std::atomic<bool> Metrics::enabled(false);
+
+    /*-- Counter --*/
+
+    void Counter::add(uint64_t n) {
+        if (Metrics::enabled.load(std::memory_order_relaxed)) value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Counter::get() {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    void Counter::reset() {
+        value.store(0, std::memory_order_relaxed);
+    }
+
+    /*-- Gauge --*/
+
+    void Gauge::set(double v) {
+        if (Metrics::enabled.load(std::memory_order_relaxed)) value.store(v, std::memory_order_relaxed);
+    }
+
+    double Gauge::get() {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    /*-- Histogram --*/
+
+    Histogram::Histogram() {
+        reset();
+    }
+
+    void Histogram::reset() {
+        for (auto & b : buckets) b.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    void Histogram::record(uint64_t micros) {
+        int b = 0;
+        uint64_t v = micros;
+        while (v > 1 && b < BUCKETS - 1) {
+            v >>= 1;
+            b++;
+        }
+        buckets[b].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(micros, std::memory_order_relaxed);
+        uint64_t curr = max.load(std::memory_order_relaxed);
+        while (micros > curr && !max.compare_exchange_weak(curr, micros, std::memory_order_relaxed)) { }
+    }
+
+    uint64_t Histogram::getCount() {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Histogram::getPercentile(float p) {
+        uint64_t total = getCount();
+        if (total == 0) return 0;
+        uint64_t target = std::max((uint64_t) 1, (uint64_t) std::ceil(total * p));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min((uint64_t) 1 << (b + 1), max.load(std::memory_order_relaxed));
+        }
+        return max.load(std::memory_order_relaxed);
+    }
+
+    ofJson Histogram::getJson() {
+        ofJson j;
+        uint64_t n = getCount();
+        j["count"] = n;
+        j["mean"] = (n > 0) ? (double) sum.load(std::memory_order_relaxed) / n : 0.0;
+        j["p50"] = getPercentile(0.5);
+        j["p90"] = getPercentile(0.9);
+        j["p99"] = getPercentile(0.99);
+        j["max"] = max.load(std::memory_order_relaxed);
+        return j;
+    }
+
+    /*-- ScopedTimer --*/
+
+    ScopedTimer::ScopedTimer(Histogram & histogram_) {
+        histogram = Metrics::enabled.load(std::memory_order_relaxed) ? &histogram_ : nullptr;
+        if (histogram) start = std::chrono::steady_clock::now();
+    }
+
+    ScopedTimer::~ScopedTimer() {
+        if (!histogram) return;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram->record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+    /*-- MetricsDumper --*/
+
+    void MetricsDumper::threadedFunction() {
+        while (isThreadRunning()) {
+            float next = ofGetElapsedTimef() + interval;
+            while (isThreadRunning() && ofGetElapsedTimef() < next) ofSleepMillis(50);
+            if (!isThreadRunning()) break;
+
+            string text = Metrics::getText();
+            if (path.empty()) {
+                ofLogNotice("ofxZED::Metrics") << "\n" << text;
+            } else {
+                ofBuffer buffer;
+                buffer.set(text);
+                ofBufferToFile(path, buffer);
+            }
+        }
+    }
+
+    /*-- Metrics --*/
+
+    Counter & Metrics::counter(string name) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto & c = counters[name];
+        if (!c) c.reset(new Counter());
+        return *c;
+    }
+
+    Gauge & Metrics::gauge(string name) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto & g = gauges[name];
+        if (!g) g.reset(new Gauge());
+        return *g;
+    }
+
+    Histogram & Metrics::histogram(string name) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto & h = histograms[name];
+        if (!h) h.reset(new Histogram());
+        return *h;
+    }
+
+    ofJson Metrics::snapshot() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ofJson j;
+        j["time"] = ofGetElapsedTimef();
+        for (auto & c : counters) j["counters"][c.first] = c.second->get();
+        for (auto & g : gauges) j["gauges"][g.first] = g.second->get();
+        for (auto & h : histograms) j["histograms"][h.first] = h.second->getJson();
+        return j;
+    }
+
+    string Metrics::getText() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::stringstream ss;
+        for (auto & c : counters) ss << c.first << " " << c.second->get() << "\n";
+        for (auto & g : gauges) ss << g.first << " " << g.second->get() << "\n";
+        for (auto & h : histograms) {
+            ss << h.first << " count=" << h.second->getCount();
+            ss << " p50=" << h.second->getPercentile(0.5) << "us";
+            ss << " p90=" << h.second->getPercentile(0.9) << "us";
+            ss << " p99=" << h.second->getPercentile(0.99) << "us\n";
+        }
+        return ss.str();
+    }
+
+    void Metrics::reset() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & c : counters) c.second->reset();
+        for (auto & h : histograms) h.second->reset();
+    }
+
+    void Metrics::startDump(float interval, string path) {
+        stopDump();
+        dumper.interval = std::max(0.1f, interval);
+        dumper.path = path;
+        dumper.startThread();
+    }
+
+    void Metrics::stopDump() {
+        if (dumper.isThreadRunning()) dumper.waitForThread(true);
+    }
+
+
+}
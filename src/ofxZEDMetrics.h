@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+
+Metrics: in-process counters, gauges and latency histograms
+
+- metrics are registered once by name and never removed, so call sites keep a reference
+  in a function-local static and pay no lookup afterwards
+- updates are relaxed atomics, histograms are log2 buckets of microseconds
+- Metrics::enabled is off by default (the indexer turns it on with --metrics), while it is
+  off nothing is recorded and a ScopedTimer does not even read the clock
+
+    static ofxZED::Histogram & grabTime = ofxZED::Metrics::histogram("player.grab");
+    ofxZED::ScopedTimer timer(grabTime);
+
+**/
+
+
+namespace ofxZED {
+
+    class Counter {
+    private:
+        std::atomic<uint64_t> value;
+    public:
+        Counter() : value(0) { };
+        void add(uint64_t n = 1);
+        uint64_t get();
+        void reset();
+    };
+
+    class Gauge {
+    private:
+        std::atomic<double> value;
+    public:
+        Gauge() : value(0) { };
+        void set(double v);
+        double get();
+    };
+
+    class Histogram {
+    public:
+        static const int BUCKETS = 40;
+    private:
+        std::atomic<uint64_t> buckets[BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    public:
+        Histogram();
+        void record(uint64_t micros);
+        void reset();
+        uint64_t getCount();
+
+        /*-- upper bound of the bucket holding the percentile, in microseconds --*/
+        uint64_t getPercentile(float p);
+        ofJson getJson();
+    };
+
+    class ScopedTimer {
+    private:
+        Histogram * histogram;
+        std::chrono::steady_clock::time_point start;
+    public:
+        ScopedTimer(Histogram & histogram_);
+        ~ScopedTimer();
+    };
+
+    class MetricsDumper : public ofThread {
+    public:
+        float interval;
+        string path;
+        void threadedFunction();
+    };
+
+    class Metrics {
+    private:
+        static std::mutex mutex;
+        static std::map<string, std::unique_ptr<Counter>> counters;
+        static std::map<string, std::unique_ptr<Gauge>> gauges;
+        static std::map<string, std::unique_ptr<Histogram>> histograms;
+        static MetricsDumper dumper;
+    public:
+
+        static std::atomic<bool> enabled;
+
+        static Counter & counter(string name);
+        static Gauge & gauge(string name);
+        static Histogram & histogram(string name);
+
+        static ofJson snapshot();
+        static string getText();
+        static void reset();
+
+        /*-- logs getText() every interval seconds, or overwrites a file when a path is given --*/
+        static void startDump(float interval, string path = "");
+        static void stopDump();
+    };
+
+
+}
@@ -27,11 +27,17 @@ NB! make a function "guessDroppedFrames()"
 namespace ofxZED {
 
     Player::Player() {
-        isSettingPosition = false;
+        pendingFrame = -1;
+        displayedFrame = -1;
+        svo = nullptr;
         left = true;
         right = false;
         depth = false;
         cloud = false;
+        colorizeDepth = false;
+        measureDepth = false;
+        autoRange = false;
+        voxelize = false;
     }
 
     void Player::init() {
@@ -49,38 +55,115 @@ namespace ofxZED {
     }
 
 
+    /*-- relative to the frame already asked for, so nudges queued before an update() add up --*/
+
     void Player::nudge( int frames ) {
-        sl::Camera::setSVOPosition( sl::Camera::getSVOPosition() + frames );
+        int from = pendingFrame.load();
+        if (from < 0) from = std::max(0, displayedFrame);
+        int last = std::max(0, getSVONumberOfFrames() - 1);
+        requestFrame( std::min(std::max(from + frames, 0), last) );
     }
 
     void Player::setSVOPosition(int i ) {
-        if (!isSettingPosition) {
-            isSettingPosition = true;
-            sl::Camera::setSVOPosition(i);
-        }
+        requestFrame(i);
+    }
+
+    void Player::requestFrame(int frame) {
+        static Counter & superseded = Metrics::counter("player.seeks_superseded");
+        if (pendingFrame.exchange(frame) >= 0) superseded.add();
+    }
+
+    bool Player::hasPendingFrame() {
+        return pendingFrame.load() >= 0;
+    }
+
+    bool Player::update() {
+        static Counter & seeks = Metrics::counter("player.seeks");
+        int frame = pendingFrame.exchange(-1);
+        if (frame < 0) return false;
+        OFXZED_TRACE("Player::setSVOPosition");
+        seeks.add();
+        showFrame(frame);
+        return true;
+    }
+
+    int Player::getDisplayedFrame() {
+        return displayedFrame;
+    }
+
+    int Player::showFrame(int frame, int maxForward) {
+        if (frame == displayedFrame) return displayedFrame;
+        int ahead = frame - displayedFrame;
+        if (displayedFrame >= 0 && ahead > 1 && ahead <= maxForward) {
+
+            /*-- a short jump forward is decoded through, a seek would decode from the keyframe anyway --*/
+
+            OFXZED_TRACE("Player::showFrame.skip");
+            sl::RuntimeParameters skip;
+            skip.enable_depth = false;
+            for (int k = 1; k < ahead; k++) {
+                if (sl::Camera::grab(skip) != sl::SUCCESS) break;
+            }
+        } else if (ahead != 1) {
+            OFXZED_TRACE("Player::showFrame.seek");
+            sl::Camera::setSVOPosition(frame);
 
+            /*-- accumulated voxels belong to the frames before the jump --*/
 
+            voxels.clear();
+        }
+        grab();
+        return displayedFrame;
+    }
+
+    void Player::releaseBuffers() {
+        for (ofPixels * p : { &leftPix, &rightPix, &depthPix, &measurePix }) p->clear();
+        for (ofTexture * t : { &leftTex, &rightTex, &depthTex, &measureTex }) t->clear();
+        for (sl::Mat * m : { &leftMat, &rightMat, &depthMat, &measureMat, &cloudMat }) m->free();
+        mesh.clear();
+        voxels.clear();
     }
 
     bool Player::openSVO(SVO * svo_) {
+        pendingFrame = -1;
+        displayedFrame = -1;
+
+        /*-- nothing measured from a previous recording carries over --*/
+
+        depthStats.reset();
+        voxels.clear();
         svo = svo_;
         return ofxZED::Camera::openSVO(svo->getSVOPath());
     }
 
     int Player::grab() {
 
-
+        static Histogram & grabTime = Metrics::histogram("player.grab");
+        static Histogram & retrieveTime = Metrics::histogram("player.retrieve");
+        static Histogram & uploadTime = Metrics::histogram("player.upload");
+        static Histogram & cloudTime = Metrics::histogram("player.cloud");
+        static Counter & grabbed = Metrics::counter("player.frames");
+        static Counter & missed = Metrics::counter("player.grab_failed");
 
         if (!sl::Camera::isOpened()) return  sl::Camera::getSVOPosition();
+        OFXZED_TRACE("Player::grab");
 
         frameNew = false;
         sl::RuntimeParameters runtime_parameters;
         runtime_parameters.sensing_mode = sl::SENSING_MODE_FILL; // Use STANDARD sensing mode
         runtime_parameters.enable_depth = depth;
 
-        if (sl::Camera::grab(runtime_parameters) == sl::SUCCESS) {
+        sl::ERROR_CODE grabbedCode;
+        {
+            ScopedTimer timer(grabTime);
+            OFXZED_TRACE("sl::Camera::grab");
+            grabbedCode = sl::Camera::grab(runtime_parameters);
+        }
+
+        if (grabbedCode == sl::SUCCESS) {
 
             frameNew = true;
+            grabbed.add();
 
             int w = getWidth();
             int h = getHeight();
@@ -95,8 +178,14 @@ namespace ofxZED {
                     leftPix.allocate(w, h, 3);
                     leftTex.allocate(w, h, GL_RGB, false);
                 }
-                sl::Camera::retrieveImage(leftMat, sl::VIEW_LEFT, sl::MEM_CPU, w,h);
-                leftPix.setFromPixels( leftMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                {
+                    ScopedTimer timer(retrieveTime);
+                    OFXZED_TRACE("Player::retrieve");
+                    sl::Camera::retrieveImage(leftMat, sl::VIEW_LEFT, sl::MEM_CPU, w,h);
+                    leftPix.setFromPixels( leftMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                }
+                ScopedTimer timer(uploadTime);
+                OFXZED_TRACE("Player::upload");
                 leftTex.loadData(leftPix);
             }
 
@@ -106,8 +195,14 @@ namespace ofxZED {
                     rightPix.allocate(w, h, 3);
                     rightTex.allocate(w, h, GL_RGB, false);
                 }
-                sl::Camera::retrieveImage(rightMat, sl::VIEW_RIGHT, sl::MEM_CPU, w,h);
-                rightPix.setFromPixels( rightMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                {
+                    ScopedTimer timer(retrieveTime);
+                    OFXZED_TRACE("Player::retrieve");
+                    sl::Camera::retrieveImage(rightMat, sl::VIEW_RIGHT, sl::MEM_CPU, w,h);
+                    rightPix.setFromPixels( rightMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                }
+                ScopedTimer timer(uploadTime);
+                OFXZED_TRACE("Player::upload");
                 rightTex.loadData(rightPix);
             }
 
@@ -117,34 +212,63 @@ namespace ofxZED {
                     depthPix.allocate(w, h, 3);
                     depthTex.allocate(w, h, GL_RGB, false);
                 }
-                sl::Camera::retrieveImage(depthMat, sl::VIEW_DEPTH, sl::MEM_CPU, w, h);
-                depthPix.setFromPixels( depthMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                {
+                    ScopedTimer timer(retrieveTime);
+                    OFXZED_TRACE("Player::retrieve");
+
+                    /*-- the 8-bit view has no range to set, so autoRange always colours the measure --*/
+
+                    if (measureDepth || autoRange) {
+                        sl::Camera::retrieveMeasure(measureMat, sl::MEASURE_DEPTH, sl::MEM_CPU, w, h);
+                        int step = measureMat.getStepBytes() / sizeof(float);
+                        depthStats.update(measureMat.getPtr<sl::float1>(), w, h, step, sl::Camera::getSVOPosition() - 1, getFrameTimestamp());
+                        if (autoRange) depthStats.applyRange(colormap);
+                        colormap.apply(measureMat.getPtr<sl::float1>(), w, h, step, depthPix);
+                    } else {
+                        sl::Camera::retrieveImage(depthMat, sl::VIEW_DEPTH, sl::MEM_CPU, w, h);
+                        if (colorizeDepth) {
+                            processMatToPix(depthPix, depthMat, true);
+                        } else {
+                            depthPix.setFromPixels( depthMat.getPtr<sl::uchar1>(), w, h, OF_PIXELS_BGRA );
+                        }
+                    }
+                }
+                ScopedTimer timer(uploadTime);
+                OFXZED_TRACE("Player::upload");
                 depthTex.loadData(depthPix);
             }
 
             if (cloud) {
+               ScopedTimer timer(cloudTime);
+               OFXZED_TRACE("Player::cloud");
                sl::Camera::retrieveMeasure(cloudMat, sl::MEASURE_XYZRGBA, sl::MEM_CPU, w, h);
-               mesh.clear();
 
-               float *data = (cloudMat.getPtr<sl::float1>());
-               unsigned char *data_char = cloudMat.getPtr<sl::uchar1>();
-               vector<glm::vec3> points;
-               vector<ofFloatColor> colors;
+               if (voxelize) {
+                   voxels.add(cloudMat.getPtr<sl::float1>(), w, h, cloudMat.getStepBytes() / sizeof(float));
+                   voxels.getMesh(mesh);
+               } else {
+                   mesh.clear();
+
+                   float *data = (cloudMat.getPtr<sl::float1>());
+                   unsigned char *data_char = cloudMat.getPtr<sl::uchar1>();
+                   vector<glm::vec3> points;
+                   vector<ofFloatColor> colors;
 
-               for (int y = 0; y < h; y++) {
-                   for (int x = 0; x < w; x++) {
-                       int index = (x + w * y) * 4;
-                       int index_color = (index + 3) *4;
+                   for (int y = 0; y < h; y++) {
+                       for (int x = 0; x < w; x++) {
+                           int index = (x + w * y) * 4;
+                           int index_color = (index + 3) *4;
 
 //                       mesh.addVertex(ofVec3f(data[index], data[index + 1], data[index + 2]));
 //                       mesh.addColor( ofFloatColor(data_char[index_color], data_char[index_color + 1], data_char[index_color + 2], data_char[index_color + 3])  );
-                       points.push_back(glm::vec3(data[index], data[index + 1], data[index + 2]));
-                       colors.push_back( ofFloatColor(data_char[index_color], data_char[index_color + 1], data_char[index_color + 2], data_char[index_color + 3])  );
+                           points.push_back(glm::vec3(data[index], data[index + 1], data[index + 2]));
+                           colors.push_back( ofFloatColor(data_char[index_color], data_char[index_color + 1], data_char[index_color + 2], data_char[index_color + 3])  );
+                       }
                    }
-               }
 
-               mesh.addVertices(points);
-               mesh.addColors(colors);
+                   mesh.addVertices(points);
+                   mesh.addColors(colors);
+               }
             }
 
 
@@ -165,11 +289,11 @@ namespace ofxZED {
 
 
             lastPosition = sl::Camera::getSVOPosition();
-
-            isSettingPosition = false;
+            displayedFrame = lastPosition - 1;
 
         } else {
 
+            missed.add();
             ofLog() << "Did not grab";
         }
 
@@ -3,6 +3,8 @@
 #include "ofMain.h"
 #include "ofxZEDCamera.h";
 #include "ofxZEDSVO.h";
+#include "ofxZEDDepthStats.h"
+#include "ofxZEDVoxelGrid.h"
 
 /* 
 
@@ -32,17 +34,52 @@ namespace ofxZED {
 
     class Player : public ofxZED::Camera {
     public:
-        bool isSettingPosition;
+    private:
+
+        /*-- latest requested frame, -1 when none is pending, newer requests overwrite older ones --*/
+        std::atomic<int> pendingFrame;
+
+        /*-- frame of the last successful grab, -1 before the first --*/
+        int displayedFrame;
+    public:
         bool left, right, depth, cloud;
+
+        /*-- depth through colormap, from the 8-bit view or from the float measure (windowed by the colormap range) --*/
+        bool colorizeDepth, measureDepth;
+
+        /*-- depth statistics of every grabbed frame, autoRange feeds them into the colormap range
+         * and so implies measureDepth --*/
+        DepthStats depthStats;
+        bool autoRange;
+
+        /*-- with voxelize, the cloud mesh holds one averaged point per voxel instead of one per pixel --*/
+        VoxelGrid voxels;
+        bool voxelize;
         void init();
         ofShader shader;
         ofPlanePrimitive plane;
         Player();
         SVO * svo;
         bool openSVO(SVO * svo_);
+
+        /*-- frees pixels, textures, sl::Mats and the mesh, they are reallocated on the next grab --*/
+        void releaseBuffers();
         int grab();
+        /*-- queues a seek, serviced by the next update(), only the latest request is decoded --*/
         void setSVOPosition(int i );
+        void requestFrame(int frame);
+        bool hasPendingFrame();
+
+        /*-- services the pending seek, returns true when a frame was decoded --*/
+        bool update();
+        int getDisplayedFrame();
+
+        /*-- queues a seek frames away from the displayed (or already pending) frame --*/
         void nudge( int frames );
+
+        /*-- decodes only the requested frame, reading on when it is at most maxForward frames ahead
+         * (frames in between are grabbed without retrieving anything) and seeking otherwise --*/
+        int showFrame(int frame, int maxForward = 1);
         // void drawStereoscopic(ofRectangle r);
     };
 
@@ -0,0 +1,192 @@
+#include "ofxZEDPlayerPool.h"
+
+
+namespace ofxZED {
+
+    PlayerPool::PlayerPool() {
+        clock = 0;
+        maxOpen = 8;
+        memoryBudget = (uint64_t) 4 << 30;
+        cameraBytes = (uint64_t) 256 << 20;
+    }
+
+    PlayerPool::~PlayerPool() {
+        clear();
+    }
+
+    Player * PlayerPool::acquire(SVO * svo) {
+
+        static Counter & hits = Metrics::counter("pool.hits");
+        static Counter & opens = Metrics::counter("pool.opens");
+        OFXZED_TRACE("PlayerPool::acquire");
+
+        string path = svo->getSVOPath();
+        auto it = open.find(path);
+        if (it != open.end()) {
+            hits.add();
+            it->second.active = true;
+            it->second.lastUsed = ++clock;
+            it->second.player->svo = svo;
+            return it->second.player;
+        }
+
+        /*-- make room before opening, only warm Players can be evicted --*/
+
+        while ((int) open.size() >= maxOpen) {
+            if (!evict()) {
+                ofLogError("ofxZED::PlayerPool") << "all" << maxOpen << "players are active, not opening" << path;
+                return nullptr;
+            }
+        }
+
+        Player * player = nullptr;
+        if (closed.size() > 0) {
+            player = closed.back();
+            closed.pop_back();
+        } else {
+            owned.push_back(std::unique_ptr<Player>(new Player()));
+            player = owned.back().get();
+        }
+
+        opens.add();
+        if (!player->openSVO(svo)) {
+            ofLogError("ofxZED::PlayerPool") << "could not open" << path;
+            player->close();
+            player->releaseBuffers();
+            closed.push_back(player);
+            return nullptr;
+        }
+
+        PoolEntry & e = open[path];
+        e.player = player;
+        e.active = true;
+        e.lastUsed = ++clock;
+
+        trim();
+        return player;
+    }
+
+    void PlayerPool::release(string path) {
+        auto it = open.find(path);
+        if (it == open.end()) return;
+        it->second.active = false;
+        it->second.lastUsed = ++clock;
+        trim();
+    }
+
+    void PlayerPool::releaseAll() {
+        for (auto & e : open) {
+            e.second.active = false;
+            e.second.lastUsed = ++clock;
+        }
+        trim();
+    }
+
+    void PlayerPool::close(std::map<string, PoolEntry>::iterator it) {
+        static Counter & evictions = Metrics::counter("pool.evictions");
+        evictions.add();
+        ofLogNotice("ofxZED::PlayerPool") << "closing" << it->first;
+        it->second.player->close();
+        it->second.player->releaseBuffers();
+        closed.push_back(it->second.player);
+        open.erase(it);
+    }
+
+    /*-- closes the least recently used warm Player --*/
+
+    bool PlayerPool::evict() {
+        auto lru = open.end();
+        for (auto it = open.begin(); it != open.end(); ++it) {
+            if (it->second.active) continue;
+            if (lru == open.end() || it->second.lastUsed < lru->second.lastUsed) lru = it;
+        }
+        if (lru == open.end()) return false;
+        close(lru);
+        return true;
+    }
+
+    void PlayerPool::trim() {
+        while ((int) open.size() > maxOpen || getMemoryUsage() > memoryBudget) {
+            if (!evict()) break;
+        }
+
+        static Gauge & openCount = Metrics::gauge("pool.open");
+        static Gauge & bytes = Metrics::gauge("pool.bytes");
+        openCount.set(open.size());
+        bytes.set(getMemoryUsage());
+    }
+
+    void PlayerPool::clear() {
+        for (auto & e : open) e.second.player->close();
+        open.clear();
+        closed.clear();
+        owned.clear();
+    }
+
+    bool PlayerPool::isOpen(string path) {
+        return open.find(path) != open.end();
+    }
+
+    int PlayerPool::getOpenCount() {
+        return open.size();
+    }
+
+    int PlayerPool::getActiveCount() {
+        int count = 0;
+        for (auto & e : open) if (e.second.active) count++;
+        return count;
+    }
+
+    int PlayerPool::getClosedCount() {
+        return closed.size();
+    }
+
+    uint64_t PlayerPool::getMemoryUsage() {
+        uint64_t total = 0;
+        for (auto & e : open) total += cameraBytes + getFootprint(e.second.player);
+        return total;
+    }
+
+    /*-- pixels are mirrored in a texture of the same size, the cloud is held in the mesh --*/
+
+    uint64_t PlayerPool::getFootprint(Player * p) {
+        uint64_t total = 0;
+        total += 2 * p->leftPix.getTotalBytes();
+        total += 2 * p->rightPix.getTotalBytes();
+        total += 2 * p->depthPix.getTotalBytes();
+        total += 2 * p->measurePix.getTotalBytes();
+        for (sl::Mat * m : { &p->leftMat, &p->rightMat, &p->depthMat, &p->measureMat, &p->cloudMat }) {
+            total += m->getStepBytes() * m->getHeight();
+        }
+        total += p->mesh.getNumVertices() * (sizeof(glm::vec3) + sizeof(ofFloatColor));
+        return total;
+    }
+
+    ofJson PlayerPool::getJson() {
+        ofJson j;
+        j["open"] = getOpenCount();
+        j["active"] = getActiveCount();
+        j["closed"] = getClosedCount();
+        j["maxOpen"] = maxOpen;
+        j["bytes"] = getMemoryUsage();
+        j["memoryBudget"] = memoryBudget;
+        for (auto & e : open) {
+            ofJson p;
+            p["path"] = e.first;
+            p["active"] = e.second.active;
+            p["bytes"] = cameraBytes + getFootprint(e.second.player);
+            j["players"].push_back(p);
+        }
+        return j;
+    }
+
+    string PlayerPool::printInfo() {
+        std::stringstream ss;
+        ss << getOpenCount() << "/" << maxOpen << " open (" << getActiveCount() << " active, ";
+        ss << getClosedCount() << " closed), ";
+        ss << (getMemoryUsage() >> 20) << "/" << (memoryBudget >> 20) << " MB";
+        return ss.str();
+    }
+
+
+}
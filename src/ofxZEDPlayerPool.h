@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDPlayer.h"
+
+/*
+
+PlayerPool: bounded set of open Players, keyed by SVO path
+
+- acquire() returns the open Player for an SVO, reopening a warm one without touching the SDK
+- release() keeps the Player open ("warm") until it is evicted, least recently used first
+- evicted Players are closed and their buffers freed, the instances are kept for the next open
+- at most maxOpen Players are open at once, warm ones are also evicted past memoryBudget
+- memory is an estimate over open Players: pixels, textures, sl::Mats, mesh and cameraBytes each,
+  closed Players hold no buffers so they are not counted
+
+    ofxZED::Player * p = pool.acquire(svo);
+    ...
+    pool.release(svo->getSVOPath());
+
+**/
+
+
+namespace ofxZED {
+
+    struct PoolEntry {
+    public:
+        Player * player;
+        bool active;
+        uint64_t lastUsed;
+    };
+
+    class PlayerPool {
+    private:
+        std::map<string, PoolEntry> open;
+        vector<std::unique_ptr<Player>> owned;
+        vector<Player *> closed;
+        uint64_t clock;
+
+        bool evict();
+        void close(std::map<string, PoolEntry>::iterator it);
+    public:
+
+        int maxOpen;
+        uint64_t memoryBudget;
+
+        /*-- the SDK's own allocations per open camera, not visible from here --*/
+        uint64_t cameraBytes;
+
+        PlayerPool();
+        ~PlayerPool();
+
+        /*-- open Player for the SVO, nullptr when every slot is active or the SVO does not open --*/
+        Player * acquire(SVO * svo);
+        void release(string path);
+        void releaseAll();
+
+        /*-- closes warm Players until within maxOpen and memoryBudget --*/
+        void trim();
+        void clear();
+
+        bool isOpen(string path);
+        int getOpenCount();
+        int getActiveCount();
+        int getClosedCount();
+        uint64_t getMemoryUsage();
+
+        static uint64_t getFootprint(Player * player);
+
+        ofJson getJson();
+        string printInfo();
+    };
+
+
+}
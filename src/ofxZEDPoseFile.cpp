@@ -0,0 +1,472 @@
+#include "ofxZEDPoseFile.h"
+
+
+namespace ofxZED {
+
+    const uint32_t PoseFile::VERSION;
+
+    /*-- zigzag varints, small deltas take a single byte --*/
+
+    static void putVarint(vector<uint8_t> & out, uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t) v);
+    }
+
+    static void putSigned(vector<uint8_t> & out, int32_t v) {
+        putVarint(out, ((uint32_t) v << 1) ^ (uint32_t)(v >> 31));
+    }
+
+    static bool getVarint(const uint8_t * & p, const uint8_t * end, uint32_t & v) {
+        v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p >= end) return false;
+            uint8_t b = *p++;
+            v |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static bool getSigned(const uint8_t * & p, const uint8_t * end, int32_t & v) {
+        uint32_t u;
+        if (!getVarint(p, end, u)) return false;
+        v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+        return true;
+    }
+
+    bool PoseFile::readJson(string path, vector<PoseFrame> & frames) {
+
+        ofJson j = ofLoadJson(path);
+        if (!j.is_object() || j.find("frames") == j.end()) {
+            ofLogError("ofxZED::PoseFile") << "no frames in" << path;
+            return false;
+        }
+
+        frames.clear();
+        frames.reserve(j["frames"].size());
+
+        for (auto & frame : j["frames"]) {
+            PoseFrame poseFrame;
+
+            if (!frame.is_null()) {
+                for (auto & person : frame) {
+                    PosePerson posePerson;
+                    for (auto & joint : person.items()) {
+
+                        try  {
+
+                            int key = ofToInt( joint.key() );
+                            float x = joint.value()[0].get<float>();
+                            float y = joint.value()[1].get<float>();
+                            float z = joint.value()[2].get<float>();
+                            float weight = joint.value()[3].get<float>();
+
+                            /*-- if is centre of gravity --*/
+
+                            if (key == -1) posePerson.center = ofVec3f(x,y,z);
+
+                            /*-- if is joint --*/
+
+                            if (key != -1)  {
+                                int to = joint.value()[4].get<int>();
+                                posePerson.joints.push_back( PoseJoint(key, ofVec3f(x,y,z), to, weight) );
+                            }
+                        } catch (std::exception & e) {
+                            ofLogError("ofxZED::PoseFile") << "pose error on joint" << joint.key() << e.what();
+                        }
+
+                    }
+                    std::sort(posePerson.joints.begin(), posePerson.joints.end(), [](const PoseJoint & a, const PoseJoint & b) {
+                        return a.key < b.key;
+                    });
+                    poseFrame.people.push_back( posePerson );
+                }
+            }
+            frames.push_back( poseFrame );
+        }
+        return true;
+    }
+
+    /*-- joints must be sorted by key, as SVO and readJson keep them --*/
+
+    void PoseFile::encode(const PoseFrame & frame, vector<QuantizedPerson> & previous, vector<uint8_t> & out) {
+
+        vector<QuantizedPerson> current(frame.people.size());
+        putVarint(out, frame.people.size());
+
+        for (int p = 0; p < frame.people.size(); p++) {
+            const PosePerson & person = frame.people[p];
+            const QuantizedPerson * ref = (p < previous.size()) ? &previous[p] : nullptr;
+            QuantizedPerson & q = current[p];
+
+            q.x = (int) std::lround(person.center.x / precision);
+            q.y = (int) std::lround(person.center.y / precision);
+            q.z = (int) std::lround(person.center.z / precision);
+            putSigned(out, q.x - (ref ? ref->x : 0));
+            putSigned(out, q.y - (ref ? ref->y : 0));
+            putSigned(out, q.z - (ref ? ref->z : 0));
+
+            putVarint(out, person.joints.size());
+            int lastKey = -1;
+            int r = 0;
+            for (auto & joint : person.joints) {
+
+                auto s = skeleton.find(joint.key);
+                if (s == skeleton.end()) s = skeleton.insert(std::make_pair(joint.key, joint.to)).first;
+                bool ownLink = s->second != joint.to;
+                if (ownLink) skeletonMismatches++;
+
+                QuantizedJoint qj;
+                qj.key = joint.key;
+                qj.x = (int) std::lround(joint.position.x / precision);
+                qj.y = (int) std::lround(joint.position.y / precision);
+                qj.z = (int) std::lround(joint.position.z / precision);
+                qj.w = (int) std::lround(joint.weight * 1000);
+
+                const QuantizedJoint * rj = nullptr;
+                if (ref) {
+                    while (r < ref->joints.size() && ref->joints[r].key < joint.key) r++;
+                    if (r < ref->joints.size() && ref->joints[r].key == joint.key) rj = &ref->joints[r];
+                }
+
+                /*-- joints without a reference are coded relative to their person's center --*/
+
+                putSigned(out, ((qj.key - lastKey) << 1) | (ownLink ? 1 : 0));
+                if (ownLink) putSigned(out, joint.to);
+                putSigned(out, qj.x - (rj ? rj->x : q.x));
+                putSigned(out, qj.y - (rj ? rj->y : q.y));
+                putSigned(out, qj.z - (rj ? rj->z : q.z));
+                putSigned(out, qj.w - (rj ? rj->w : 0));
+                lastKey = qj.key;
+                q.joints.push_back(qj);
+            }
+        }
+        previous.swap(current);
+    }
+
+    bool PoseFile::decode(const uint8_t * & p, const uint8_t * end, vector<QuantizedPerson> & previous, PoseFrame & frame) {
+
+        uint32_t peopleCount;
+        if (!getVarint(p, end, peopleCount)) return false;
+
+        vector<QuantizedPerson> current(peopleCount);
+        frame.people.clear();
+        frame.people.resize(peopleCount);
+
+        for (int i = 0; i < peopleCount; i++) {
+            const QuantizedPerson * ref = (i < previous.size()) ? &previous[i] : nullptr;
+            QuantizedPerson & q = current[i];
+            int32_t dx, dy, dz, dw, dk;
+            uint32_t jointCount;
+
+            if (!getSigned(p, end, dx) || !getSigned(p, end, dy) || !getSigned(p, end, dz)) return false;
+            q.x = dx + (ref ? ref->x : 0);
+            q.y = dy + (ref ? ref->y : 0);
+            q.z = dz + (ref ? ref->z : 0);
+            frame.people[i].center = ofVec3f(q.x * precision, q.y * precision, q.z * precision);
+
+            if (!getVarint(p, end, jointCount)) return false;
+            int lastKey = -1;
+            int r = 0;
+            for (int k = 0; k < jointCount; k++) {
+                if (!getSigned(p, end, dk)) return false;
+                int32_t to = -1;
+                bool ownLink = false;
+                if (version >= 2) {
+                    ownLink = dk & 1;
+                    dk >>= 1;
+                    if (ownLink && !getSigned(p, end, to)) return false;
+                }
+                QuantizedJoint qj;
+                qj.key = lastKey + dk;
+                lastKey = qj.key;
+
+                const QuantizedJoint * rj = nullptr;
+                if (ref) {
+                    while (r < ref->joints.size() && ref->joints[r].key < qj.key) r++;
+                    if (r < ref->joints.size() && ref->joints[r].key == qj.key) rj = &ref->joints[r];
+                }
+
+                if (!getSigned(p, end, dx) || !getSigned(p, end, dy) || !getSigned(p, end, dz) || !getSigned(p, end, dw)) return false;
+                qj.x = dx + (rj ? rj->x : q.x);
+                qj.y = dy + (rj ? rj->y : q.y);
+                qj.z = dz + (rj ? rj->z : q.z);
+                qj.w = dw + (rj ? rj->w : 0);
+                q.joints.push_back(qj);
+
+                if (!ownLink) {
+                    auto s = skeleton.find(qj.key);
+                    to = (s != skeleton.end()) ? s->second : -1;
+                }
+                frame.people[i].joints.push_back( PoseJoint(qj.key, ofVec3f(qj.x * precision, qj.y * precision, qj.z * precision), to, qj.w / 1000.0f) );
+            }
+        }
+        previous.swap(current);
+        return true;
+    }
+
+    bool PoseFile::write(string path, const vector<PoseFrame> & frames) {
+
+        /*-- frames are encoded first, the skeleton table is only known afterwards --*/
+
+        skeleton.clear();
+        skeletonMismatches = 0;
+        vector<uint8_t> data;
+        vector<uint64_t> relative;
+        vector<QuantizedPerson> previous;
+        for (int i = 0; i < frames.size(); i++) {
+            if (i % keyframeInterval == 0) previous.clear();
+            relative.push_back(data.size());
+            encode(frames[i], previous, data);
+        }
+        if (skeletonMismatches > 0) {
+            ofLogNotice("ofxZED::PoseFile") << skeletonMismatches << "joints disagree with the skeleton table, their links are stored with them";
+        }
+
+        std::ofstream out(ofToDataPath(path), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            ofLogError("ofxZED::PoseFile") << "could not write" << path;
+            return false;
+        }
+
+        version = VERSION;
+        uint32_t interval = keyframeInterval;
+        uint32_t frameCount = frames.size();
+        uint32_t skeletonCount = skeleton.size();
+        out.write("ZEDP", 4);
+        out.write((const char *) &version, sizeof(version));
+        out.write((const char *) &precision, sizeof(precision));
+        out.write((const char *) &interval, sizeof(interval));
+        out.write((const char *) &frameCount, sizeof(frameCount));
+        out.write((const char *) &skeletonCount, sizeof(skeletonCount));
+        for (auto & s : skeleton) {
+            int32_t key = s.first;
+            int32_t to = s.second;
+            out.write((const char *) &key, sizeof(key));
+            out.write((const char *) &to, sizeof(to));
+        }
+
+        uint64_t dataStart = out.tellp();
+        out.write((const char *) data.data(), data.size());
+
+        offsets.clear();
+        for (auto & r : relative) offsets.push_back(dataStart + r);
+        indexOffset = dataStart + data.size();
+        out.write((const char *) offsets.data(), offsets.size() * sizeof(uint64_t));
+        out.write((const char *) &indexOffset, sizeof(indexOffset));
+        return (bool) out;
+    }
+
+    bool PoseFile::open(string path) {
+
+        close();
+        in.open(ofToDataPath(path), std::ios::binary);
+        char magic[4];
+        version = 0;
+        if (!in.read(magic, 4) || string(magic, 4) != "ZEDP" || !in.read((char *) &version, sizeof(version)) || version < 1 || version > VERSION) {
+            ofLogError("ofxZED::PoseFile") << "not a pose file" << path;
+            close();
+            return false;
+        }
+
+        /*-- nothing in the header is trusted until it fits the file, so a truncated or corrupt
+         * file fails here (and loadPoses falls back to the json) instead of allocating its counts --*/
+
+        in.seekg(0, std::ios::end);
+        uint64_t fileSize = (uint64_t) in.tellg();
+        in.seekg(4 + sizeof(version));
+
+        uint32_t interval = 0;
+        uint32_t frameCount = 0;
+        uint32_t skeletonCount = 0;
+        in.read((char *) &precision, sizeof(precision));
+        in.read((char *) &interval, sizeof(interval));
+        in.read((char *) &frameCount, sizeof(frameCount));
+        in.read((char *) &skeletonCount, sizeof(skeletonCount));
+        uint64_t skeletonStart = (uint64_t) in.tellg();
+        uint64_t dataStart = skeletonStart + (uint64_t) skeletonCount * 2 * sizeof(int32_t);
+        if (!in || dataStart + sizeof(indexOffset) > fileSize) {
+            ofLogError("ofxZED::PoseFile") << "truncated pose file header" << path;
+            close();
+            return false;
+        }
+
+        keyframeInterval = std::max(1, (int) interval);
+        skeleton.clear();
+        for (int i = 0; i < skeletonCount; i++) {
+            int32_t key, to;
+            in.read((char *) &key, sizeof(key));
+            in.read((char *) &to, sizeof(to));
+            skeleton[key] = to;
+        }
+
+        in.seekg(fileSize - sizeof(indexOffset));
+        in.read((char *) &indexOffset, sizeof(indexOffset));
+        if (!in || indexOffset < dataStart || indexOffset > fileSize || fileSize - indexOffset != (uint64_t) frameCount * sizeof(uint64_t) + sizeof(indexOffset)) {
+            ofLogError("ofxZED::PoseFile") << "frame index does not fit" << path;
+            close();
+            return false;
+        }
+
+        in.seekg(indexOffset);
+        offsets.resize(frameCount);
+        in.read((char *) offsets.data(), frameCount * sizeof(uint64_t));
+        if (!in) {
+            ofLogError("ofxZED::PoseFile") << "truncated pose file" << path;
+            close();
+            return false;
+        }
+
+        for (int i = 0; i < offsets.size(); i++) {
+            if (offsets[i] < dataStart || offsets[i] > indexOffset || (i > 0 && offsets[i] < offsets[i-1])) {
+                ofLogError("ofxZED::PoseFile") << "corrupt frame offset" << i << "in" << path;
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void PoseFile::close() {
+        if (in.is_open()) in.close();
+        in.clear();
+        offsets.clear();
+        cachedFrame = -1;
+        cachedState.clear();
+    }
+
+    int PoseFile::getNumFrames() {
+        return offsets.size();
+    }
+
+    /*-- decodes forward from the nearest keyframe, or from the last frame read when reading in order --*/
+
+    bool PoseFile::readFrame(int i, PoseFrame & frame) {
+
+        if (!in.is_open() || i < 0 || i >= offsets.size()) return false;
+
+        int keyframe = i - i % keyframeInterval;
+        int from = (cachedFrame >= keyframe && cachedFrame < i) ? cachedFrame + 1 : keyframe;
+        if (from == keyframe) cachedState.clear();
+
+        uint64_t begin = offsets[from];
+        uint64_t end = (i + 1 < offsets.size()) ? offsets[i + 1] : indexOffset;
+        vector<uint8_t> buffer(end - begin);
+        in.clear();
+        in.seekg(begin);
+        if (!in.read((char *) buffer.data(), buffer.size())) {
+            cachedFrame = -1;
+            return false;
+        }
+
+        const uint8_t * p = buffer.data();
+        PoseFrame skipped;
+        for (int f = from; f <= i; f++) {
+            if (!decode(p, buffer.data() + buffer.size(), cachedState, (f == i) ? frame : skipped)) {
+                ofLogError("ofxZED::PoseFile") << "corrupt frame" << f;
+                cachedFrame = -1;
+                return false;
+            }
+        }
+        cachedFrame = i;
+        return true;
+    }
+
+    bool PoseFile::readAll(vector<PoseFrame> & frames) {
+
+        frames.clear();
+        if (!in.is_open()) return false;
+        if (offsets.size() <= 0) return true;
+
+        vector<uint8_t> buffer(indexOffset - offsets[0]);
+        in.clear();
+        in.seekg(offsets[0]);
+        if (!in.read((char *) buffer.data(), buffer.size())) return false;
+
+        frames.resize(offsets.size());
+        const uint8_t * p = buffer.data();
+        vector<QuantizedPerson> previous;
+        for (int i = 0; i < frames.size(); i++) {
+            if (i % keyframeInterval == 0) previous.clear();
+            if (!decode(p, buffer.data() + buffer.size(), previous, frames[i])) {
+                ofLogError("ofxZED::PoseFile") << "corrupt frame" << i;
+                frames.resize(i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ofJson PoseFile::convert(string jsonPath, string binaryPath, float precision, int keyframeInterval) {
+
+        ofJson report;
+        report["source"] = jsonPath;
+        report["ok"] = false;
+
+        vector<PoseFrame> original;
+        if (!readJson(jsonPath, original)) return report;
+
+        PoseFile writer;
+        writer.precision = precision;
+        writer.keyframeInterval = std::max(1, keyframeInterval);
+        if (!writer.write(binaryPath, original)) return report;
+
+        PoseFile reader;
+        vector<PoseFrame> decoded;
+        if (!reader.open(binaryPath) || !reader.readAll(decoded)) return report;
+
+        /*-- every position should come back within half a quantization step per axis --*/
+
+        uint64_t joints = 0;
+        uint64_t countMismatches = 0;
+        uint64_t linkMismatches = 0;
+        double errorSum = 0;
+        float maxError = 0;
+        float maxWeightError = 0;
+        for (int i = 0; i < original.size(); i++) {
+            if (i >= decoded.size() || original[i].people.size() != decoded[i].people.size()) {
+                countMismatches++;
+                continue;
+            }
+            for (int p = 0; p < original[i].people.size(); p++) {
+                const PosePerson & a = original[i].people[p];
+                const PosePerson & b = decoded[i].people[p];
+                maxError = std::max(maxError, a.center.distance(b.center));
+                if (a.joints.size() != b.joints.size()) {
+                    countMismatches++;
+                    continue;
+                }
+                for (int k = 0; k < a.joints.size(); k++) {
+                    float error = a.joints[k].position.distance(b.joints[k].position);
+                    maxError = std::max(maxError, error);
+                    maxWeightError = std::max(maxWeightError, std::abs(a.joints[k].weight - b.joints[k].weight));
+                    if (a.joints[k].key != b.joints[k].key || a.joints[k].to != b.joints[k].to) linkMismatches++;
+                    errorSum += error;
+                    joints++;
+                }
+            }
+        }
+
+        uint64_t jsonSize = ofFile(jsonPath).getSize();
+        uint64_t binarySize = ofFile(binaryPath).getSize();
+        report["binary"] = binaryPath;
+        report["frames"] = original.size();
+        report["joints"] = joints;
+        report["jsonBytes"] = jsonSize;
+        report["binaryBytes"] = binarySize;
+        report["ratio"] = (binarySize > 0) ? (double) jsonSize / binarySize : 0.0;
+        report["maxError"] = maxError;
+        report["meanError"] = (joints > 0) ? errorSum / joints : 0.0;
+        report["maxWeightError"] = maxWeightError;
+        report["countMismatches"] = countMismatches;
+        report["skeletonMismatches"] = writer.skeletonMismatches;
+        report["linkMismatches"] = linkMismatches;
+        report["ok"] = countMismatches == 0 && linkMismatches == 0 && maxError <= precision * 0.87f + 1e-6f && maxWeightError <= 0.0005f + 1e-6f;
+        return report;
+    }
+
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDPoses.h"
+
+/*
+
+PoseFile: compact binary sidecar for .svo.poses, written next to it as .svo.poses.bin
+
+    "ZEDP" u32 version, f32 precision, u32 keyframe interval, u32 frames
+    u32 skeleton size, { i32 key, i32 to } ...
+    frames ...
+    u64 offset per frame
+    u64 offset of the frame index
+
+- positions are quantized to precision (camera units), weights to 1/1000
+- joints are stored as zigzag varints, delta coded against the same person and key
+  in the previous frame (people are referenced by their order in the frame)
+- every keyframe interval a frame is coded without references, so any frame is
+  reached by decoding at most one interval from the nearest keyframe
+- `to` links come from the skeleton table (the first link seen for each key), a joint whose
+  link differs from it stores its own: the key delta's low bit flags a varint `to` after it
+  (version 2, version 1 files have no flag and always take the table's link)
+
+**/
+
+
+namespace ofxZED {
+
+    class PoseFile {
+    private:
+
+        struct QuantizedJoint {
+            int key;
+            int x, y, z, w;
+        };
+
+        struct QuantizedPerson {
+            int x, y, z;
+            vector<QuantizedJoint> joints;
+        };
+
+        std::ifstream in;
+        uint32_t version;
+        uint64_t indexOffset;
+        int cachedFrame;
+        vector<QuantizedPerson> cachedState;
+
+        void encode(const PoseFrame & frame, vector<QuantizedPerson> & previous, vector<uint8_t> & out);
+        bool decode(const uint8_t * & p, const uint8_t * end, vector<QuantizedPerson> & previous, PoseFrame & frame);
+
+    public:
+
+        float precision;
+        int keyframeInterval;
+        std::map<int, int> skeleton;
+        vector<uint64_t> offsets;
+
+        /*-- joints written with their own link, as it differs from the skeleton table --*/
+        int skeletonMismatches;
+
+        static const uint32_t VERSION = 2;
+
+        PoseFile() { precision = 0.001; keyframeInterval = 30; version = VERSION; indexOffset = 0; cachedFrame = -1; skeletonMismatches = 0; };
+
+        /*-- the original textual format, [x, y, z, weight, to] per joint and key -1 for the center --*/
+        static bool readJson(string path, vector<PoseFrame> & frames);
+
+        bool write(string path, const vector<PoseFrame> & frames);
+
+        bool open(string path);
+        void close();
+        int getNumFrames();
+        bool readFrame(int i, PoseFrame & frame);
+        bool readAll(vector<PoseFrame> & frames);
+
+        /*-- writes the binary next to the json and reads it back, reporting sizes and round-trip error --*/
+        static ofJson convert(string jsonPath, string binaryPath, float precision = 0.001, int keyframeInterval = 30);
+    };
+
+
+}
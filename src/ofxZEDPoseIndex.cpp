@@ -0,0 +1,354 @@
+#include "ofxZEDPoseIndex.h"
+
+#include <sys/stat.h>
+
+
+namespace ofxZED {
+
+    static const int CELL_OFFSET = 1 << 20;
+    static const uint64_t CELL_MASK = (1 << 21) - 1;
+
+    int64_t PoseIndex::getBucket(uint64_t timestamp) {
+        return (int64_t)(timestamp / bucketDuration);
+    }
+
+    /*-- clamped to the 21 bits a key holds per axis, far outliers share the edge cells --*/
+
+    int PoseIndex::getCell(float v) {
+        float cell = std::floor(v / cellSize);
+        if (std::isnan(cell)) return 0;
+        return (int) std::min(std::max(cell, (float) -CELL_OFFSET), (float) (CELL_OFFSET - 1));
+    }
+
+    uint64_t PoseIndex::getCellKey(int x, int y, int z) {
+        return (((uint64_t)(x + CELL_OFFSET) & CELL_MASK) << 42) | (((uint64_t)(y + CELL_OFFSET) & CELL_MASK) << 21) | ((uint64_t)(z + CELL_OFFSET) & CELL_MASK);
+    }
+
+    bool PoseIndex::getFingerprint(string path, uint64_t & size, int64_t & modified) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return false;
+        size = st.st_size;
+        modified = st.st_mtime;
+        return true;
+    }
+
+    void PoseIndex::clear() {
+        files.clear();
+        hits.clear();
+        buckets.clear();
+    }
+
+    /*-- reads poses and timestamps, leaving the SVO as paged in or out as it was --*/
+
+    void PoseIndex::collect(SVO & svo, int id, vector<PoseHit> & out) {
+
+        bool hadTables = svo.hasTables();
+        bool hadPoses = svo.poseTable.size() > 0;
+        svo.checkForPoses();
+        svo.checkForLookup();
+
+        /*-- a manifest entry only knows its first and last frame, every other pose would be dropped --*/
+
+        if (!svo.hasTables()) {
+            ofLogWarning("ofxZED::PoseIndex") << "no timestamps for" << svo.filename << ", not indexed until it has a .lookup";
+            if (!hadPoses) svo.releasePoses();
+            return;
+        }
+
+        for (int i = 0; i < svo.poseTable.size() && svo.hasTimestampIdx(i); i++) {
+            for (auto & person : svo.poseTable[i].people) {
+                PoseHit hit;
+                hit.file = id;
+                hit.frame = i;
+                hit.timestamp = svo.frames[i].timestamp;
+                hit.center = person.center;
+                out.push_back(hit);
+            }
+        }
+
+        if (!hadPoses) svo.releasePoses();
+        if (!hadTables) svo.releaseTables();
+    }
+
+    void PoseIndex::build(vector<SVO *> svos, int workers) {
+
+        float startTime = ofGetElapsedTimef();
+
+        /*-- hits of the previous index, grouped by file name --*/
+
+        std::map<string, int> previous;
+        for (int i = 0; i < files.size(); i++) previous[files[i].filename] = i;
+        vector<vector<PoseHit>> previousHits(files.size());
+        for (auto & hit : hits) previousHits[hit.file].push_back(hit);
+
+        vector<PoseIndexFile> nextFiles;
+        vector<SVO *> sources;
+        for (auto & svo : svos) {
+            PoseIndexFile file;
+            file.filename = svo->filename;
+            string posesPath = svo->hasPosesBinaryFile() ? svo->getPosesBinaryPath() : svo->getPosesPath();
+            if (!getFingerprint(ofToDataPath(posesPath), file.size, file.modified)) continue;
+            if (!getFingerprint(ofToDataPath(svo->getLookupPath()), file.lookupSize, file.lookupModified)) {
+                file.lookupSize = 0;
+                file.lookupModified = 0;
+            }
+            nextFiles.push_back(file);
+            sources.push_back(svo);
+        }
+
+        vector<vector<PoseHit>> perFile(nextFiles.size());
+        std::atomic<int> next(0);
+        std::atomic<int> reused(0);
+        auto work = [&]() {
+            int idx;
+            while ((idx = next++) < nextFiles.size()) {
+                auto it = previous.find(nextFiles[idx].filename);
+                const PoseIndexFile & file = nextFiles[idx];
+                bool isUnchanged = it != previous.end() && file.lookupSize > 0;
+                if (isUnchanged) {
+                    const PoseIndexFile & old = files[it->second];
+                    isUnchanged = old.size == file.size && old.modified == file.modified && old.lookupSize == file.lookupSize && old.lookupModified == file.lookupModified;
+                }
+                if (isUnchanged) {
+                    perFile[idx] = previousHits[it->second];
+                    for (auto & hit : perFile[idx]) hit.file = idx;
+                    reused++;
+                } else {
+                    collect(*sources[idx], idx, perFile[idx]);
+                }
+            }
+        };
+
+        int count = std::min(std::max(1, workers), (int)nextFiles.size());
+        vector<std::thread> pool;
+        for (int i = 1; i < count; i++) pool.emplace_back(work);
+        work();
+        for (auto & t : pool) t.join();
+
+        files.swap(nextFiles);
+        hits.clear();
+        for (auto & h : perFile) hits.insert(hits.end(), h.begin(), h.end());
+
+        sortHits();
+
+        ofLogNotice("ofxZED::PoseIndex") << "indexed" << hits.size() << "centers from" << files.size() << "files," << reused << "reused in" << ofGetElapsedTimef() - startTime << "s";
+    }
+
+    /*-- removing keeps the hits in order, only later file ids shift down --*/
+
+    bool PoseIndex::remove(string filename) {
+        int id = -1;
+        for (int i = 0; i < files.size(); i++) if (files[i].filename == filename) id = i;
+        if (id < 0) return false;
+
+        files.erase(files.begin() + id);
+        hits.erase(std::remove_if(hits.begin(), hits.end(), [id](const PoseHit & hit) { return hit.file == id; }), hits.end());
+        for (auto & hit : hits) if (hit.file > id) hit.file--;
+        rebuildBuckets();
+        return true;
+    }
+
+    /*-- a renamed file keeps its hits, the changed .lookup mtime recollects it on the next build --*/
+
+    bool PoseIndex::rename(string from, string to) {
+        bool renamed = false;
+        for (auto & file : files) {
+            if (file.filename == from) {
+                file.filename = to;
+                renamed = true;
+            }
+        }
+        return renamed;
+    }
+
+    /*-- replaces the hits of one file, ie. after it was rescraped --*/
+
+    bool PoseIndex::update(SVO & svo) {
+        bool removed = remove(svo.filename);
+
+        PoseIndexFile file;
+        file.filename = svo.filename;
+        string posesPath = svo.hasPosesBinaryFile() ? svo.getPosesBinaryPath() : svo.getPosesPath();
+        if (!getFingerprint(ofToDataPath(posesPath), file.size, file.modified)) return removed;
+        if (!getFingerprint(ofToDataPath(svo.getLookupPath()), file.lookupSize, file.lookupModified)) {
+            file.lookupSize = 0;
+            file.lookupModified = 0;
+        }
+        files.push_back(file);
+        collect(svo, files.size() - 1, hits);
+        sortHits();
+        return true;
+    }
+
+    void PoseIndex::sortHits() {
+        std::sort(hits.begin(), hits.end(), [this](const PoseHit & a, const PoseHit & b) {
+            int64_t ba = getBucket(a.timestamp);
+            int64_t bb = getBucket(b.timestamp);
+            if (ba != bb) return ba < bb;
+            uint64_t ka = getCellKey(getCell(a.center.x), getCell(a.center.y), getCell(a.center.z));
+            uint64_t kb = getCellKey(getCell(b.center.x), getCell(b.center.y), getCell(b.center.z));
+            if (ka != kb) return ka < kb;
+            return a.timestamp < b.timestamp;
+        });
+        rebuildBuckets();
+    }
+
+    /*-- hits are sorted, so each (bucket, cell) run becomes one range --*/
+
+    void PoseIndex::rebuildBuckets() {
+        buckets.clear();
+        int64_t currBucket = 0;
+        uint64_t currKey = 0;
+        Range * range = nullptr;
+        for (int i = 0; i < hits.size(); i++) {
+            int64_t bucket = getBucket(hits[i].timestamp);
+            uint64_t key = getCellKey(getCell(hits[i].center.x), getCell(hits[i].center.y), getCell(hits[i].center.z));
+            if (range == nullptr || bucket != currBucket || key != currKey) {
+                currBucket = bucket;
+                currKey = key;
+                range = &buckets[bucket][key];
+                range->first = i;
+                range->count = 0;
+            }
+            range->count++;
+        }
+    }
+
+    vector<PoseHit> PoseIndex::query(ofVec3f min, ofVec3f max, uint64_t start, uint64_t end) {
+
+        vector<PoseHit> out;
+        int x0 = getCell(min.x), y0 = getCell(min.y), z0 = getCell(min.z);
+        int x1 = getCell(max.x), y1 = getCell(max.y), z1 = getCell(max.z);
+        uint64_t cellCount = (uint64_t)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+
+        auto test = [&](const Range & range) {
+            for (int i = range.first; i < range.first + range.count; i++) {
+                const PoseHit & hit = hits[i];
+                if (hit.timestamp < start || hit.timestamp > end) continue;
+                if (hit.center.x < min.x || hit.center.y < min.y || hit.center.z < min.z) continue;
+                if (hit.center.x > max.x || hit.center.y > max.y || hit.center.z > max.z) continue;
+                out.push_back(hit);
+            }
+        };
+
+        auto first = buckets.lower_bound(getBucket(start));
+        auto last = buckets.upper_bound(getBucket(end));
+        for (auto b = first; b != last; ++b) {
+
+            /*-- large regions scan the occupied cells instead of probing empty ones --*/
+
+            if (cellCount > b->second.size()) {
+                for (auto & cell : b->second) test(cell.second);
+                continue;
+            }
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    for (int z = z0; z <= z1; z++) {
+                        auto cell = b->second.find(getCellKey(x, y, z));
+                        if (cell != b->second.end()) test(cell->second);
+                    }
+                }
+            }
+        }
+
+        std::sort(out.begin(), out.end(), [](const PoseHit & a, const PoseHit & b) {
+            return a.timestamp < b.timestamp;
+        });
+        return out;
+    }
+
+    string PoseIndex::getFilename(const PoseHit & hit) {
+        if (hit.file < 0 || hit.file >= files.size()) return "";
+        return files[hit.file].filename;
+    }
+
+    bool PoseIndex::save(string path) {
+
+        std::ofstream out(ofToDataPath(path), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            ofLogError("ofxZED::PoseIndex") << "could not write" << path;
+            return false;
+        }
+
+        uint32_t version = 2;
+        uint32_t fileCount = files.size();
+        uint64_t hitCount = hits.size();
+        out.write("ZEDI", 4);
+        out.write((const char *) &version, sizeof(version));
+        out.write((const char *) &cellSize, sizeof(cellSize));
+        out.write((const char *) &bucketDuration, sizeof(bucketDuration));
+        out.write((const char *) &fileCount, sizeof(fileCount));
+        for (auto & file : files) {
+            uint32_t length = file.filename.size();
+            out.write((const char *) &length, sizeof(length));
+            out.write(file.filename.data(), length);
+            out.write((const char *) &file.size, sizeof(file.size));
+            out.write((const char *) &file.modified, sizeof(file.modified));
+            out.write((const char *) &file.lookupSize, sizeof(file.lookupSize));
+            out.write((const char *) &file.lookupModified, sizeof(file.lookupModified));
+        }
+        out.write((const char *) &hitCount, sizeof(hitCount));
+        for (auto & hit : hits) {
+            out.write((const char *) &hit.file, sizeof(hit.file));
+            out.write((const char *) &hit.frame, sizeof(hit.frame));
+            out.write((const char *) &hit.timestamp, sizeof(hit.timestamp));
+            out.write((const char *) hit.center.getPtr(), 3 * sizeof(float));
+        }
+        return (bool) out;
+    }
+
+    bool PoseIndex::load(string path) {
+
+        std::ifstream in(ofToDataPath(path), std::ios::binary);
+        char magic[4];
+        uint32_t version = 0;
+        if (!in.read(magic, 4) || string(magic, 4) != "ZEDI" || !in.read((char *) &version, sizeof(version)) || version < 1 || version > 2) {
+            ofLogNotice("ofxZED::PoseIndex") << "no pose index at" << path;
+            return false;
+        }
+
+        clear();
+        uint32_t fileCount = 0;
+        uint64_t hitCount = 0;
+        in.read((char *) &cellSize, sizeof(cellSize));
+        in.read((char *) &bucketDuration, sizeof(bucketDuration));
+        in.read((char *) &fileCount, sizeof(fileCount));
+        files.resize(fileCount);
+        for (auto & file : files) {
+            uint32_t length = 0;
+            in.read((char *) &length, sizeof(length));
+            file.filename.resize(length);
+            in.read(&file.filename[0], length);
+            in.read((char *) &file.size, sizeof(file.size));
+            in.read((char *) &file.modified, sizeof(file.modified));
+
+            /*-- version 1 had no lookup fingerprint, its hits are collected again on the next build --*/
+
+            file.lookupSize = 0;
+            file.lookupModified = 0;
+            if (version >= 2) {
+                in.read((char *) &file.lookupSize, sizeof(file.lookupSize));
+                in.read((char *) &file.lookupModified, sizeof(file.lookupModified));
+            }
+        }
+        in.read((char *) &hitCount, sizeof(hitCount));
+        hits.resize(hitCount);
+        for (auto & hit : hits) {
+            in.read((char *) &hit.file, sizeof(hit.file));
+            in.read((char *) &hit.frame, sizeof(hit.frame));
+            in.read((char *) &hit.timestamp, sizeof(hit.timestamp));
+            in.read((char *) hit.center.getPtr(), 3 * sizeof(float));
+        }
+
+        if (!in) {
+            ofLogError("ofxZED::PoseIndex") << "truncated pose index" << path;
+            clear();
+            return false;
+        }
+        rebuildBuckets();
+        ofLogNotice("ofxZED::PoseIndex") << "loaded" << hits.size() << "centers from" << files.size() << "files";
+        return true;
+    }
+
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDSVO.h"
+
+/*
+
+PoseIndex: database-wide spatio-temporal index of person centers
+
+- centers are bucketed by time (bucketDuration) and then by a uniform 3D grid (cellSize)
+- hits are stored sorted by (bucket, cell), so every cell is one contiguous range
+- the index is a binary sidecar next to the manifest, <name>_poses.idx
+- rebuilding reuses the hits of every file whose poses and .lookup sizes and mtimes are unchanged
+- files without timestamp tables (no .lookup) are left out until they have one
+
+**/
+
+
+namespace ofxZED {
+
+    struct PoseHit {
+    public:
+        int32_t file;
+        int32_t frame;
+        uint64_t timestamp;
+        ofVec3f center;
+    };
+
+    struct PoseIndexFile {
+    public:
+        string filename;
+        uint64_t size;
+        int64_t modified;
+        uint64_t lookupSize;
+        int64_t lookupModified;
+    };
+
+    class PoseIndex {
+    private:
+
+        struct Range {
+            int first;
+            int count;
+        };
+
+        std::map<int64_t, std::unordered_map<uint64_t, Range>> buckets;
+
+        int64_t getBucket(uint64_t timestamp);
+        int getCell(float v);
+        static uint64_t getCellKey(int x, int y, int z);
+        static bool getFingerprint(string path, uint64_t & size, int64_t & modified);
+        void collect(SVO & svo, int id, vector<PoseHit> & hits);
+        void sortHits();
+        void rebuildBuckets();
+
+    public:
+
+        /*-- camera units (meters) and nanoseconds, fixed once the index is built --*/
+        float cellSize;
+        uint64_t bucketDuration;
+
+        vector<PoseIndexFile> files;
+        vector<PoseHit> hits;
+
+        PoseIndex() { cellSize = 0.5; bucketDuration = 60000000000ULL; };
+
+        void build(vector<SVO *> svos, int workers = 1);
+
+        /*-- drops the hits of one file, ie. when its SVO is removed from the database --*/
+        bool remove(string filename);
+        bool rename(string from, string to);
+        bool update(SVO & svo);
+
+        bool save(string path);
+        bool load(string path);
+        void clear();
+
+        /*-- every center inside the box [min, max] between start and end --*/
+        vector<PoseHit> query(ofVec3f min, ofVec3f max, uint64_t start, uint64_t end);
+
+        string getFilename(const PoseHit & hit);
+    };
+
+
+}
@@ -0,0 +1,68 @@
+#include "ofxZEDPoses.h"
+
+
+namespace ofxZED {
+
+    float Poses::maxMatchDistance = 0.5;
+
+    /*-- joints are sorted by key, so both lists are merged in one pass --*/
+
+    PosePerson Poses::interpolate(const PosePerson & a, const PosePerson & b, float t) {
+
+        PosePerson out;
+        out.center = a.center.getInterpolated(b.center, t);
+        out.joints.reserve(std::max(a.joints.size(), b.joints.size()));
+
+        int i = 0, j = 0;
+        while (i < a.joints.size() || j < b.joints.size()) {
+            if (j >= b.joints.size() || (i < a.joints.size() && a.joints[i].key < b.joints[j].key)) {
+                if (t < 0.5) out.joints.push_back(a.joints[i]);
+                i++;
+            } else if (i >= a.joints.size() || b.joints[j].key < a.joints[i].key) {
+                if (t >= 0.5) out.joints.push_back(b.joints[j]);
+                j++;
+            } else {
+                const PoseJoint & ja = a.joints[i];
+                const PoseJoint & jb = b.joints[j];
+                out.joints.push_back( PoseJoint(ja.key, ja.position.getInterpolated(jb.position, t), ja.to, ofLerp(ja.weight, jb.weight, t)) );
+                i++;
+                j++;
+            }
+        }
+        return out;
+    }
+
+    /*-- greedy nearest-center matching, unmatched people come from the nearer frame --*/
+
+    vector<PosePerson> Poses::interpolate(const PoseFrame & a, const PoseFrame & b, float t) {
+
+        vector<PosePerson> out;
+        vector<bool> usedB(b.people.size(), false);
+        float maxSquared = maxMatchDistance * maxMatchDistance;
+
+        for (auto & pa : a.people) {
+            int best = -1;
+            float bestDistance = maxSquared;
+            for (int k = 0; k < b.people.size(); k++) {
+                if (usedB[k]) continue;
+                float d = pa.center.squareDistance(b.people[k].center);
+                if (d <= bestDistance) {
+                    best = k;
+                    bestDistance = d;
+                }
+            }
+            if (best >= 0) {
+                usedB[best] = true;
+                out.push_back( interpolate(pa, b.people[best], t) );
+            } else if (t < 0.5) {
+                out.push_back(pa);
+            }
+        }
+        if (t >= 0.5) {
+            for (int k = 0; k < b.people.size(); k++) if (!usedB[k]) out.push_back(b.people[k]);
+        }
+        return out;
+    }
+
+
+}
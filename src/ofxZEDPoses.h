@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+
+Poses: flat per-frame pose tables kept next to ofxPose::Animation
+
+- one PoseFrame per SVO frame, people hold their joints sorted by key
+- interpolation matches people between two frames by their nearest center,
+  then blends joints with the same key
+
+**/
+
+
+namespace ofxZED {
+
+    struct PoseJoint {
+    public:
+        int key;
+        ofVec3f position;
+        int to;
+        float weight;
+        PoseJoint(int key_, ofVec3f position_, int to_, float weight_) {
+            key = key_;
+            position = position_;
+            to = to_;
+            weight = weight_;
+        }
+    };
+
+    struct PosePerson {
+    public:
+        ofVec3f center;
+        vector<PoseJoint> joints;
+    };
+
+    struct PoseFrame {
+    public:
+        vector<PosePerson> people;
+    };
+
+    class Poses {
+    public:
+
+        /*-- people further apart than this (in camera units) are never matched --*/
+        static float maxMatchDistance;
+
+        static PosePerson interpolate(const PosePerson & a, const PosePerson & b, float t);
+        static vector<PosePerson> interpolate(const PoseFrame & a, const PoseFrame & b, float t);
+    };
+
+
+}
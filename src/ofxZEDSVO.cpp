@@ -1,58 +1,254 @@
 #include "ofxZEDSVO.h"
+#include "ofxZEDScraper.h"
+
+#include <sys/stat.h>
 
 namespace ofxZED {
 
-    void SVO::scrape(ofxZED::Camera & zed) {
+    const int SVO::LOOKUP_VERSION;
+
+    /*-- scrapes frame timestamps, committing them to a .partial checkpoint as it goes
+     * a previous checkpoint is resumed from its last committed frame --*/
+
+    bool SVO::scrape(ofxZED::Camera & zed) {
         frames.clear();
         lookup.clear();
 
-        ofLogNotice("ofxZED::SVO") << "beginning scrape";
-
-        zed.setSVOPosition(0);
         int total = zed.getSVONumberOfFrames();
+        int first = loadCheckpoint();
+        resumedFrames = first;
+        frames.reserve(total);
 
-        for (int i = 0; i < total; i++) {
+        if (first > 0) {
+            ofLogNotice("ofxZED::SVO") << "resuming scrape at" << first << "of" << total;
+        } else {
+            ofLogNotice("ofxZED::SVO") << "beginning scrape";
+        }
 
-            float tt = ofGetElapsedTimef();
-            bool timeout = false;
-            while ( zed.grab() != sl::SUCCESS && !timeout )  {
-                if (ofGetElapsedTimef() > tt + 2) {
-                    ofLogError("ofxZED::Database") << "timout";
-                    timeout = true;
-                }
-                sl::sleep_ms(1);
+        zed.setSVOPosition(first);
+        std::ofstream checkpoint(ofToDataPath(getCheckpointPath()), std::ios::binary | std::ios::app);
+        isComplete = false;
+
+        for (int i = first; i < total; i++) {
+
+            if (!Scraper::grab(zed)) {
+                ofLogError("ofxZED::SVO") << "timeout at frame" << i << ", keeping checkpoint";
+                break;
+            }
+
+            uint64_t timestamp = zed.getFrameTimestamp();
+            int frameIdx = zed.getSVOPosition()-1;
+
+            if (frameIdx != i) {
+                ofLogError("ofxZED::SVO") << "something went wrong:" << frameIdx << "does not equal" << i;
             }
+            frames.push_back( Frame(frameIdx, timestamp) );
+
+            int32_t f = frameIdx;
+            checkpoint.write((const char *) &f, sizeof(f));
+            checkpoint.write((const char *) &timestamp, sizeof(timestamp));
+            if (frames.size() % checkpointInterval == 0) checkpoint.flush();
+        }
+
+        checkpoint.flush();
+        isComplete = (frames.size() >= total);
+        buildLookup();
+
+        if (!isComplete) ofLogError("ofxZED::SVO") << "partial scrape" << frames.size() << "of" << total << "frames";
+        return isComplete;
+    }
+
+    /*-- same as scrape(), but the remaining frames are split over segments with one Camera each,
+     * the checkpoint is extended as the contiguous prefix of finished segments grows --*/
+
+    bool SVO::scrapeSegments(int segments) {
+        frames.clear();
+        lookup.clear();
+
+        CameraSource probe(path);
+        if (!probe.open()) {
+            ofLogError("ofxZED::SVO") << "could not open" << path;
+            return false;
+        }
+        int total = probe.getNumberOfFrames();
+        probe.close();
+
+        int first = loadCheckpoint();
+        resumedFrames = first;
+        frames.reserve(total);
+
+        string svoPath = path;
+        Scraper::SourceFactory factory = [svoPath]() {
+            return std::unique_ptr<FrameSource>(new CameraSource(svoPath));
+        };
+
+        /*-- the stitched prefix is appended to the checkpoint each time it grows --*/
+
+        int committed = first;
+        Scraper::PrefixCallback onPrefix = [this, &committed](const vector<Frame> & prefix) {
+            saveCheckpoint(committed);
+            committed = prefix.size();
+        };
+        bool stitched = Scraper::scrape(factory, first, total, segments, frames, onPrefix);
+
+        isComplete = stitched && (frames.size() >= total);
+        buildLookup();
+
+        if (!isComplete) ofLogError("ofxZED::SVO") << "partial scrape" << frames.size() << "of" << total << "frames";
+        return isComplete;
+    }
+
+    /*-- lookup is the map for the nominal fps --*/
+
+    void SVO::buildLookup() {
+        clearResampled();
+        lookup = resample(frames, std::max(1, fps));
+    }
+
+    /*-- one merge pass over ticks and frames, tick times in integer nanoseconds --*/
+
+    vector<int> SVO::resample(const vector<Frame> & frames, double rate, uint64_t phase) {
+
+        vector<int> out;
+        if (frames.size() <= 0 || rate <= 0) return out;
+
+        uint64_t start = frames.front().timestamp + phase;
+        uint64_t end = frames.back().timestamp;
+        if (start > end) return out;
+
+        long double period = 1000000000.0L / rate;
+        size_t ticks = (size_t)((long double)(end - start) / period) + 1;
+        out.resize(ticks);
+
+        int j = 0;
+        int last = frames.size() - 1;
+        for (size_t k = 0; k < ticks; k++) {
+            uint64_t t = start + (uint64_t)(k * period);
+            while (j < last && frames[j + 1].timestamp <= t) j++;
+            out[k] = j;
+        }
+        return out;
+    }
+
+    std::shared_ptr<const vector<int>> SVO::getResampled(double rate, uint64_t phase) {
+
+        std::pair<double, uint64_t> key(rate, phase);
+        {
+            std::unique_lock<std::mutex> lock(resampleCache->mutex);
+            auto it = resampleCache->maps.find(key);
+            if (it != resampleCache->maps.end()) return it->second;
+        }
+
+        checkForLookup();
+        if (!hasTables()) {
+            ofLogError("ofxZED::SVO") << "no tables loaded for" << filename << ", not resampling";
+            return nullptr;
+        }
+        std::shared_ptr<const vector<int>> map = std::make_shared<const vector<int>>(resample(frames, rate, phase));
 
-            if (!timeout) {
+        std::unique_lock<std::mutex> lock(resampleCache->mutex);
+        resampleCache->maps[key] = map;
+        return map;
+    }
+
+    void SVO::clearResampled() {
+        std::unique_lock<std::mutex> lock(resampleCache->mutex);
+        resampleCache->maps.clear();
+    }
+
+    string SVO::getCheckpointPath() {
+        return path.substr(0, path.size() - 4) + ".partial";
+    }
+
+    bool SVO::hasCheckpoint() {
+        return ofFile::doesFileExist(getCheckpointPath(), false);
+    }
+
+    void SVO::removeCheckpoint() {
+        if (hasCheckpoint()) ofFile::removeFile(getCheckpointPath(), false);
+    }
+
+    /*-- reads whole committed records only, a torn trailing record is cut off --*/
+
+    int SVO::loadCheckpoint() {
+        if (!hasCheckpoint()) return 0;
+
+        std::ifstream in(ofToDataPath(getCheckpointPath()), std::ios::binary);
+        const size_t recordSize = sizeof(int32_t) + sizeof(uint64_t);
+        int32_t f;
+        uint64_t timestamp;
+        while (in.read((char *) &f, sizeof(f)) && in.read((char *) &timestamp, sizeof(timestamp))) {
+            frames.push_back( Frame(f, timestamp) );
+        }
+        in.close();
 
-                uint64_t timestamp = zed.getFrameTimestamp();
-                int frameIdx = zed.getSVOPosition()-1;
-                float fps = zed.getCameraFPS();
+        ofFile file(getCheckpointPath());
+        if (file.getSize() != frames.size() * recordSize) {
+            ofLogNotice("ofxZED::SVO") << "trimming torn checkpoint record" << getCheckpointPath();
+            saveCheckpoint(0);
+        }
+        return frames.size();
+    }
 
-                if (frameIdx != i) {
-                    ofLogError("ofxZED::Database") << "something went wrong:" << frameIdx << "does not equal" << i;
+    /*-- writes frames from an index onwards, from 0 the checkpoint is rewritten --*/
+
+    void SVO::saveCheckpoint(int from) {
+        std::ios::openmode mode = std::ios::binary | ((from == 0) ? std::ios::trunc : std::ios::app);
+        std::ofstream out(ofToDataPath(getCheckpointPath()), mode);
+        for (int i = from; i < frames.size(); i++) {
+            int32_t f = frames[i].frame;
+            out.write((const char *) &f, sizeof(f));
+            out.write((const char *) &frames[i].timestamp, sizeof(frames[i].timestamp));
+        }
+    }
+
+    /*-- trusted frames are the longest run that keeps increasing (by at least one ns per frame),
+     * found over the whole table so a single forward spike can't disqualify everything after it,
+     * only the frames outside it are rewritten, interpolated between their trusted neighbours --*/
+
+    int SVO::repairTimestamps() {
+        int n = frames.size();
+        if (n < 2) return 0;
+
+        /*-- longest non-decreasing subsequence of timestamp - index, by patience sorting --*/
+
+        vector<int64_t> keys(n);
+        for (int i = 0; i < n; i++) keys[i] = (int64_t) frames[i].timestamp - i;
+        vector<int> tails;
+        vector<int> previous(n, -1);
+        for (int i = 0; i < n; i++) {
+            auto it = std::upper_bound(tails.begin(), tails.end(), keys[i], [&](int64_t k, int t) { return k < keys[t]; });
+            if (it != tails.begin()) previous[i] = *(it - 1);
+            if (it == tails.end()) {
+                tails.push_back(i);
+            } else {
+                *it = i;
+            }
+        }
+        vector<bool> trusted(n, false);
+        for (int i = tails.back(); i >= 0; i = previous[i]) trusted[i] = true;
+
+        uint64_t period = 1000000000ULL / std::max(1, fps);
+        int repaired = 0;
+        int last = -1;
+        for (int i = 0; i <= n; i++) {
+            if (i < n && !trusted[i]) continue;
+
+            /*-- outliers between last and i: interpolate, or extrapolate at the ends --*/
+
+            for (int j = last + 1; j < i; j++) {
+                if (last >= 0 && i < n) {
+                    frames[j].timestamp = frames[last].timestamp + (frames[i].timestamp - frames[last].timestamp) * (j - last) / (i - last);
+                } else if (last >= 0) {
+                    frames[j].timestamp = frames[last].timestamp + period * (j - last);
+                } else {
+                    frames[j].timestamp = frames[i].timestamp - period * (i - j);
                 }
-               frames.push_back( Frame(frameIdx, timestamp) );
-               int repetitions = 0;
-               if (i > 0) {
-                   float millis = ofxZED::SVO::getDurationMillis(frames[i-1].timestamp, timestamp);
-                   float fpsMillis = 1000.0/fps;
-                   float effectiveFps = 1000.0/millis;
-                   repetitions =  round(millis/fpsMillis);
-                   for (auto _ = repetitions; _--;) lookup.push_back(i);
-               }
-
-               bool printProgress = false;
-
-               if (printProgress) {
-                string actualStr = ofToString(i)+"/"+ofToString(total);
-                std::cout.flush();
-                std::cout << "... lookup table: "+ofToString(lookup.size())+" "+actualStr+"";
-                std::cout.flush();
-               }
+                repaired++;
             }
+            last = i;
         }
-
+        return repaired;
     }
 
     bool SVO::hasPoseIdx(int i ) {
@@ -73,19 +269,31 @@ namespace ofxZED {
     string SVO::getPosesPath() {
          return path + ".poses";
     }
+    string SVO::getPosesBinaryPath() {
+         return path + ".poses.bin";
+    }
     string SVO::getSVOPath() {
          return path;
     }
 
+    /*-- manifest entries only hold the first and last frame until their .lookup is paged in --*/
+
+    bool SVO::hasTables() {
+        return frames.size() > 2;
+    }
+
     bool SVO::hasLookupFile() {
 
         return ofFile::doesFileExist(getLookupPath(), false);
     }
     bool SVO::hasPosesFile() {
 
-        return ofFile::doesFileExist(getPosesPath(), false);
+        return ofFile::doesFileExist(getPosesPath(), false) || hasPosesBinaryFile();
 
     }
+    bool SVO::hasPosesBinaryFile() {
+        return ofFile::doesFileExist(getPosesBinaryPath(), false);
+    }
     void SVO::checkForPoses() {
         if (poses.frames.size() <= 3 && hasPosesFile()) {
             ofLogNotice("ofxZED::SVO") << "poses not loaded yet";
@@ -94,12 +302,14 @@ namespace ofxZED {
 
     }
     void SVO::checkForLookup() {
-        if (lookup.size() <= 3 && hasLookupFile()) {
-
-            ofLogNotice("ofxZED::SVO") << "lookup not loaded yet";
-            loadLookup();
+        if (hasTables() || isLookupMissing) return;
+        if (!hasLookupFile()) {
+            isLookupMissing = true;
+            return;
         }
 
+        ofLogNotice("ofxZED::SVO") << "lookup not loaded yet";
+        loadLookup();
     }
 
     int SVO::getLookupIndex(int i) {
@@ -110,65 +320,174 @@ namespace ofxZED {
         return lookup[i];
     }
 
-    void SVO::loadPoses() {
-        ofLogNotice("ofxZED::SVO") << "loading .svo.poses" << getPosesPath();
+    int SVO::getFrameFromTimestamp(uint64_t time) {
+        checkForLookup();
+        if (frames.size() <= 0) return 0;
+        auto it = std::upper_bound(frames.begin(), frames.end(), time, [](uint64_t t, const Frame & f) {
+            return t < f.timestamp;
+        });
+        int i = (int)(it - frames.begin()) - 1;
+        return ofClamp(i, 0, frames.size() - 1);
+    }
+
+    vector<PosePerson> SVO::samplePoses(int i, uint64_t time) {
+        if (poseTable.size() <= 0) return {};
+        if (i + 1 >= frames.size() || i + 1 >= poseTable.size() || time <= frames[i].timestamp) {
+            return poseTable[std::min(i, (int)poseTable.size() - 1)].people;
+        }
+        double t = (double)(time - frames[i].timestamp) / (double)(frames[i+1].timestamp - frames[i].timestamp);
+        return Poses::interpolate(poseTable[i], poseTable[i+1], std::min(t, 1.0));
+    }
 
-        ofJson j = ofLoadJson(getPosesPath());
-        ofLogNotice("ofxZED::SVO") << "parsing .svo.poses" << j["frames"].size() << "frames";
+    vector<PosePerson> SVO::getPosesAt(uint64_t time) {
+        checkForPoses();
+        return samplePoses(getFrameFromTimestamp(time), time);
+    }
 
-        for (auto & frame : j["frames"]) {
-            ofxPose::Frame frame_;
+    vector<vector<PosePerson>> SVO::getPosesAt(const vector<uint64_t> & times) {
+        checkForPoses();
+        checkForLookup();
 
-            if (!frame.is_null()) {
-                for (auto & person : frame) {
-                    ofxPose::Person person_;
-                    for (auto & joint : person.items()) {
+        vector<vector<PosePerson>> out(times.size());
+        if (frames.size() <= 0) return out;
 
-                        try  {
+        vector<int> order(times.size());
+        for (int k = 0; k < order.size(); k++) order[k] = k;
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return times[a] < times[b]; });
 
-                            int key = ofToInt( joint.key() );
-                            float x = joint.value()[0].get<float>();
-                            float y = joint.value()[1].get<float>();
-                            float z = joint.value()[2].get<float>();
-                            float weight = joint.value()[3].get<float>();
+        int i = 0;
+        for (auto & k : order) {
+            while (i + 1 < frames.size() && frames[i+1].timestamp <= times[k]) i++;
+            out[k] = samplePoses(i, times[k]);
+        }
+        return out;
+    }
 
-                            /*-- if is centre of gravity --*/
+    /*-- the binary sidecar is preferred, unless the json was written after it (ie. re-exported
+     * poses) or it can't be read, then the json is parsed --*/
 
-                            if (key == -1) person_.center = ofVec3f(x,y,z);
+    static bool isNewer(string path, string than) {
+        struct stat a, b;
+        if (stat(ofToDataPath(path).c_str(), &a) != 0) return false;
+        if (stat(ofToDataPath(than).c_str(), &b) != 0) return true;
+        return a.st_mtime > b.st_mtime;
+    }
 
-                            /*-- if is joint --*/
+    void SVO::loadPoses() {
 
-                            if (key != -1)  {
-                                int to = joint.value()[4].get<int>();
-                                person_.add( key, ofxPose::Joint(key, ofVec3f(x,y,z), to, weight) );
-                                frame_.raw.push_back( ofVec3f(x,y,z) );
-                            }
-                        } catch (int e) {
-                            ofLogError("ofxZED::SVO") << "pose error on joint" << joint;
-                        }
+        static Histogram & loadTime = Metrics::histogram("svo.load_poses");
+        ScopedTimer timer(loadTime);
+        OFXZED_TRACE("SVO::loadPoses");
 
-                    }
-                    frame_.add( person_ );
-                }
-            } else {
+        bool loaded = false;
+        if (hasPosesBinaryFile() && !isNewer(getPosesPath(), getPosesBinaryPath())) {
+            ofLogNotice("ofxZED::SVO") << "loading .svo.poses.bin" << getPosesBinaryPath();
+            PoseFile file;
+            loaded = file.open(getPosesBinaryPath()) && file.readAll(poseTable);
+        }
+        if (!loaded) {
+            if (hasPosesBinaryFile()) ofLogNotice("ofxZED::SVO") << ".svo.poses.bin is stale or unreadable, using" << getPosesPath();
+            ofLogNotice("ofxZED::SVO") << "loading .svo.poses" << getPosesPath();
+            if (!PoseFile::readJson(getPosesPath(), poseTable)) poseTable.clear();
+        }
 
+        poses = ofxPose::Animation();
+        for (auto & poseFrame : poseTable) {
+            ofxPose::Frame frame_;
+            for (auto & posePerson : poseFrame.people) {
+                ofxPose::Person person_;
+                person_.center = posePerson.center;
+                for (auto & joint : posePerson.joints) {
+                    person_.add( joint.key, ofxPose::Joint(joint.key, joint.position, joint.to, joint.weight) );
+                    frame_.raw.push_back( joint.position );
+                }
+                frame_.add( person_ );
             }
-
             poses.add( frame_ );
         }
-        ofLogNotice("ofxZED::SVO") << "success .svo.poses" << j["frames"].size() << "frames";
+        ofLogNotice("ofxZED::SVO") << "success poses" << poseTable.size() << "frames";
     }
 
     void SVO::loadLookup() {
+        static Histogram & loadTime = Metrics::histogram("svo.load_lookup");
+        ScopedTimer timer(loadTime);
+        OFXZED_TRACE("SVO::loadLookup");
         ofLogNotice("ofxZED::SVO") << "loading lookup table" << getLookupPath();
         ofJson j = ofLoadJson(getLookupPath());
         init(j);
+
+        /*-- init() already rebuilt an old format lookup, persist it so readers agree --*/
+
+        if (j.value("lookupVersion", 1) < LOOKUP_VERSION && frames.size() > 0) {
+            ofLogNotice("ofxZED::SVO") << "upgrading lookup" << getLookupPath() << "to version" << LOOKUP_VERSION;
+            ofSaveJson(getLookupPath(), getJson(true));
+        }
+    }
+
+    void SVO::releaseTables() {
+        if (frames.size() <= 2) return;
+        vector<Frame> ends;
+        ends.push_back( frames.front() );
+        ends.push_back( frames.back() );
+        frames.swap(ends);
+        vector<int>().swap(lookup);
+        clearResampled();
+    }
+
+    void SVO::releasePoses() {
+        vector<ofxPose::Frame>().swap(poses.frames);
+        vector<PoseFrame>().swap(poseTable);
+    }
+
+    uint64_t SVO::getTimestamp(int i) {
+        checkForLookup();
+        if (!hasTimestampIdx(i) || i < 0) {
+            ofLogError("ofxZED::SVO") << "no timestamp at this index" << i;
+            return (i < 0) ? getStart() : getEnd();
+        }
+        return frames[i].timestamp;
     }
 
     void SVO::init( ofFile &f, int fps_) {
+        isLookupMissing = false;
         filename = f.getFileName();
         path = f.getAbsolutePath();
         fps = fps_;
+        updateFingerprint();
+    }
+
+    bool SVO::readFingerprint(uint64_t & size, int64_t & modified) {
+        struct stat st;
+        if (stat(ofToDataPath(path).c_str(), &st) != 0) return false;
+        size = st.st_size;
+        modified = st.st_mtime;
+        return true;
+    }
+
+    void SVO::updateFingerprint() {
+        readFingerprint(fileSize, fileModified);
+    }
+
+    /*-- entries without a fingerprint (older manifests) are trusted --*/
+
+    bool SVO::hasChanged() {
+        uint64_t size;
+        int64_t modified;
+        if (fileSize == 0 || !readFingerprint(size, modified)) return false;
+        return size != fileSize || modified != fileModified;
+    }
+
+    /*-- explicit table copy for derived databases --*/
+
+    void SVO::init( SVO & parent, string path_ ) {
+        isLookupMissing = false;
+        filename = ofFilePath::getFileName(path_);
+        path = path_;
+        fps = parent.fps;
+        isComplete = parent.isComplete;
+        frames = parent.frames;
+        lookup = parent.lookup;
+        updateFingerprint();
     }
 
     int SVO::getTotalLookupFrames() {
@@ -376,10 +695,6 @@ namespace ofxZED {
         info += path;
         info += ",";
         info += ofToString( fps );
-//        info += ',';
-//        for (int i = 0; i < frames.size(); i++) info += ofToString(frames[i].timestamp) + " ";
-//        info += ',';
-//        for (int i = 0; i < lookup.size(); i++) info += ofToString(lookup[i]) + " ";
         info += '\n';
 
         return info;
@@ -391,24 +706,45 @@ namespace ofxZED {
         j["filename"] = filename;
         j["path"] = path;
         j["fps"] = fps;
+        j["complete"] = isComplete;
+        if (fileSize > 0) j["size"] = fileSize;
+        if (fileSize > 0) j["modified"] = fileModified;
         if (withTables) {
             for (int i = 0; i < frames.size(); i++) j["timestamps"][i] = frames[i].timestamp;
             for (int i = 0; i < lookup.size(); i++) j["lookup"][i] = lookup[i];
+            j["lookupVersion"] = LOOKUP_VERSION;
         } else {
             j["timestamps"][0] = frames[0].timestamp;
             j["timestamps"][1] = frames[frames.size()-1].timestamp;
         }
         return j;
     }
-    void SVO::init( ofJson j ) {
+    void SVO::init( const ofJson & j ) {
 
+        isLookupMissing = false;
         frames.clear();
         lookup.clear();
-        filename = j["filename"].get<string>();
-        path = j["path"].get<string>();
-        fps = j["fps"].get<int>();
-        for (int i = 0; i < j["timestamps"].size(); i++) frames.push_back( Frame(i, j["timestamps"][i].get<uint64_t>()));
-        for (int i = 0; i < j["lookup"].size(); i++) lookup.push_back( j["lookup"][i].get<int>() );
+        clearResampled();
+        filename = j.value("filename", filename);
+        path = j.value("path", path);
+        fps = j.value("fps", fps);
+        isComplete = j.value("complete", true);
+        fileSize = j.value("size", fileSize);
+        fileModified = j.value("modified", fileModified);
+
+        /*-- j is const, operator[] on a missing key is undefined, getJson(false) writes no lookup --*/
+
+        auto timestamps = j.find("timestamps");
+        if (timestamps != j.end() && timestamps->is_array()) {
+            frames.reserve(timestamps->size());
+            for (int i = 0; i < timestamps->size(); i++) frames.push_back( Frame(i, (*timestamps)[i].get<uint64_t>()));
+        }
+        auto table = j.find("lookup");
+        if (table != j.end() && table->is_array()) {
+            lookup.reserve(table->size());
+            for (int i = 0; i < table->size(); i++) lookup.push_back( (*table)[i].get<int>() );
+        }
+        if (lookup.size() > 0 && j.value("lookupVersion", 1) < LOOKUP_VERSION) buildLookup();
     }
 
     bool SVO::sortSVO(ofxZED::SVO & a, ofxZED::SVO & b) {
@@ -420,6 +756,11 @@ namespace ofxZED {
        return ((a->getStart()) < (b->getStart()) );
     }
 
+    bool SVO::sortSVOHandles(const std::shared_ptr<ofxZED::SVO> & a, const std::shared_ptr<ofxZED::SVO> & b)
+    {
+       return ((a->getStart()) < (b->getStart()) );
+    }
+
 
 
 }
@@ -4,6 +4,8 @@
 #include <sl/Camera.hpp>
 #include "ofxZEDCamera.h"
 #include "ofxPose.h"
+#include "ofxZEDPoses.h"
+#include "ofxZEDPoseFile.h"
 
 
 namespace ofxZED {
@@ -18,25 +20,69 @@ namespace ofxZED {
         }
     };
 
+    /*-- frame maps per (rate, phase), shared so SVO stays movable --*/
+
+    struct ResampleCache {
+    public:
+        std::mutex mutex;
+        std::map<std::pair<double, uint64_t>, std::shared_ptr<const vector<int>>> maps;
+    };
+
     class SVO {
     private:
         vector<int> lookup;
+
+        /*-- set once checkForLookup found no sidecar, so per-frame getters don't stat it every call,
+         * cleared by init() --*/
+        bool isLookupMissing = false;
+
+        std::shared_ptr<ResampleCache> resampleCache = std::make_shared<ResampleCache>();
+        void clearResampled();
+        vector<PosePerson> samplePoses(int i, uint64_t time);
     public:
 
 
         ofxPose::Animation poses;
+        vector<PoseFrame> poseTable;
         vector<Frame> frames;
         string filename;
         string path;
-        int fps;
+        int fps = 0;
+
+        /*-- false while a scrape stopped early, the .partial checkpoint is resumed on next build --*/
+        bool isComplete = true;
+        int checkpointInterval = 500;
+
+        /*-- frames the last scrape took from the checkpoint rather than the SVO --*/
+        int resumedFrames = 0;
+
+        /*-- .lookup sidecar format: 1 repeated the later frame round(ms/fps) times, 2 holds the
+         * last frame at or before each nominal tick (see resample), older sidecars are rebuilt on load --*/
+        static const int LOOKUP_VERSION = 2;
+
+        /*-- size and mtime of the .svo when it was last scraped, 0 when unknown --*/
+        uint64_t fileSize = 0;
+        int64_t fileModified = 0;
 
         SVO() { }
 
+        /*-- SVOs are owned through std::shared_ptr handles, tables are moved but never copied --*/
+
+        SVO(const SVO &) = delete;
+        SVO & operator=(const SVO &) = delete;
+        SVO(SVO &&) = default;
+        SVO & operator=(SVO &&) = default;
+
         void init( ofFile & f, int fps_);
-        void init( ofJson j );
+        void init( const ofJson & j );
+        void init( SVO & parent, string path_ );
 
         /*-- util --*/
 
+        bool readFingerprint(uint64_t & size, int64_t & modified);
+        void updateFingerprint();
+        bool hasChanged();
+
         uint64_t getStart();
         uint64_t getEnd();
 
@@ -70,6 +116,7 @@ namespace ofxZED {
 
         static bool sortSVO(SVO & a, SVO & b);
         static bool sortSVOPtrs(SVO * a, SVO * b);
+        static bool sortSVOHandles(const std::shared_ptr<SVO> & a, const std::shared_ptr<SVO> & b);
 
 
         /*-- info --*/
@@ -81,6 +128,18 @@ namespace ofxZED {
         int getLookupIndexFromTimestamp(uint64_t time);
         int getLookupIndex(int i);
 
+        /*-- pages in the full tables on demand, frames[i] is only valid once loaded --*/
+        uint64_t getTimestamp(int i);
+
+        /*-- last frame at or before a timestamp, by binary search over frames --*/
+        int getFrameFromTimestamp(uint64_t time);
+
+        /*-- poses at any timestamp, joints interpolated between the neighbouring frames --*/
+        vector<PosePerson> getPosesAt(uint64_t time);
+
+        /*-- batched, one pass over frames for many instants in any order --*/
+        vector<vector<PosePerson>> getPosesAt(const vector<uint64_t> & times);
+
 
         bool threadPoses_, threadLookup_;
 
@@ -91,22 +150,44 @@ namespace ofxZED {
         bool hasLookupIdx(int i );
         bool hasTimestampIdx(int i );
 
+        bool hasTables();
         bool hasLookupFile();
         bool hasPosesFile();
+        bool hasPosesBinaryFile();
 
-        void scrape(ofxZED::Camera & zed);
+        bool scrape(ofxZED::Camera & zed);
+        bool scrapeSegments(int segments);
+        void buildLookup();
+
+        /*-- index into frames for every tick of a target rate, starting at getStart() + phase,
+         * each tick shows the last frame at or before it, getResampled returns nullptr without tables --*/
+
+        static vector<int> resample(const vector<Frame> & frames, double rate, uint64_t phase = 0);
+        std::shared_ptr<const vector<int>> getResampled(double rate, uint64_t phase = 0);
+
+        string getCheckpointPath();
+        bool hasCheckpoint();
+        int loadCheckpoint();
+        void saveCheckpoint(int from);
+        int repairTimestamps();
+        void removeCheckpoint();
 
         float getAverageFPS();
         string getDroppedPercent();
         string printInfo();
         string getLookupPath();
         string getPosesPath();
+        string getPosesBinaryPath();
         string getSVOPath();
         string getName();
 
         void loadPoses();
         void loadLookup();
 
+        /*-- frees frames and lookup, keeping only start and end as in the manifest --*/
+        void releaseTables();
+        void releasePoses();
+
         /*-- formats --*/
 
         string getCSV();
@@ -116,4 +197,3 @@ namespace ofxZED {
 
 
 }
-
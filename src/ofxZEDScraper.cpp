@@ -0,0 +1,219 @@
+#include "ofxZEDScraper.h"
+
+
+namespace ofxZED {
+
+    /*-- CameraSource --*/
+
+    CameraSource::CameraSource(string path_, float timeout_) {
+        path = path_;
+        timeout = timeout_;
+    }
+
+    bool CameraSource::open() {
+        camera.init.depth_mode = sl::DEPTH_MODE_NONE;
+        return camera.openSVO(path);
+    }
+
+    void CameraSource::close() {
+        if (camera.isOpened()) camera.close();
+    }
+
+    int CameraSource::getNumberOfFrames() {
+        return camera.getSVONumberOfFrames();
+    }
+
+    void CameraSource::seek(int frame) {
+        camera.setSVOPosition(frame);
+    }
+
+    bool CameraSource::next(Frame & frame) {
+        if (!Scraper::grab(camera, timeout)) return false;
+        frame.frame = camera.getSVOPosition() - 1;
+        frame.timestamp = camera.getFrameTimestamp();
+        return true;
+    }
+
+    /*-- TableSource --*/
+
+    TableSource::TableSource(vector<Frame> table_) {
+        table = table_;
+        position = 0;
+        failAt = -1;
+    }
+
+    bool TableSource::open() {
+        return true;
+    }
+
+    int TableSource::getNumberOfFrames() {
+        return table.size();
+    }
+
+    void TableSource::seek(int frame) {
+        position = frame;
+    }
+
+    bool TableSource::next(Frame & frame) {
+        if (position < 0 || position >= table.size()) return false;
+        if (position == failAt) {
+            failAt = -1;
+            return false;
+        }
+        frame = table[position++];
+        return true;
+    }
+
+    /*-- Scraper --*/
+
+    bool Scraper::grab(Camera & camera, float timeout) {
+        float tt = ofGetElapsedTimef();
+        while ( camera.grab() != sl::SUCCESS )  {
+            if (ofGetElapsedTimef() > tt + timeout) return false;
+            sl::sleep_ms(1);
+        }
+        return true;
+    }
+
+    vector<Segment> Scraper::split(int first, int total, int count) {
+        vector<Segment> segments;
+        int length = total - first;
+        count = std::max(1, std::min(count, length));
+        for (int i = 0; i < count; i++) {
+            int start = first + (int)(((int64_t)length * i) / count);
+            int end = first + (int)(((int64_t)length * (i + 1)) / count);
+            segments.push_back( Segment(start, end) );
+        }
+        return segments;
+    }
+
+    void Scraper::scrapeSegment(FrameSource & source, Segment & segment) {
+        segment.frames.reserve(segment.end - segment.start);
+        int from = segment.start + segment.frames.size();
+        source.seek(from);
+        Frame frame(0, 0);
+        for (int i = from; i < segment.end; i++) {
+            if (!source.next(frame)) {
+                ofLogError("ofxZED::Scraper") << "segment" << segment.start << "-" << segment.end << "stopped at" << i;
+                return;
+            }
+            segment.frames.push_back(frame);
+        }
+        segment.isComplete = true;
+    }
+
+    bool Scraper::stitch(Segment & segment, vector<Frame> & frames) {
+
+        for (int j = 0; j < segment.frames.size(); j++) {
+            Frame & f = segment.frames[j];
+            if (f.frame != segment.start + j) {
+                ofLogError("ofxZED::Scraper") << "frame" << f.frame << "does not equal" << segment.start + j << ", cutting segment there";
+                segment.frames.erase(segment.frames.begin() + j, segment.frames.end());
+                segment.isComplete = false;
+                break;
+            }
+        }
+        if (!segment.isComplete) return false;
+
+        if (segment.frames.size() > 0 && frames.size() > 0 && segment.frames[0].timestamp <= frames.back().timestamp) {
+            ofLogError("ofxZED::Scraper") << "timestamps not increasing across segment seam at" << segment.start;
+        }
+        frames.insert(frames.end(), segment.frames.begin(), segment.frames.end());
+        return true;
+    }
+
+    bool Scraper::scrape(SourceFactory factory, int first, int total, int count, vector<Frame> & frames, PrefixCallback onPrefix) {
+
+        if (first >= total) return true;
+
+        vector<Segment> segments = split(first, total, count);
+        ofLogNotice("ofxZED::Scraper") << "scraping" << total - first << "frames in" << segments.size() << "segments";
+
+        /*-- whoever finishes a segment stitches every finished segment after the prefix,
+         * so the prefix (and its checkpoint) grows while later segments still run --*/
+
+        std::mutex mutex;
+        vector<bool> done(segments.size(), false);
+        int next = 0;
+        auto advance = [&]() {
+            int from = next;
+            while (next < segments.size() && done[next] && stitch(segments[next], frames)) next++;
+            if (next > from && onPrefix) onPrefix(frames);
+        };
+        auto run = [&factory](Segment & segment) {
+            std::unique_ptr<FrameSource> source = factory();
+            if (source && source->open()) {
+                scrapeSegment(*source, segment);
+                source->close();
+            } else {
+                ofLogError("ofxZED::Scraper") << "could not open source for segment" << segment.start;
+            }
+        };
+
+        vector<std::thread> pool;
+        for (int i = 0; i < segments.size(); i++) {
+            pool.emplace_back([&, i]() {
+                run(segments[i]);
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = true;
+                advance();
+            });
+        }
+        for (auto & t : pool) t.join();
+
+        /*-- one more go at every segment that stopped early, from where it stopped --*/
+
+        for (int i = next; i < segments.size(); i++) {
+            if (segments[i].isComplete) continue;
+            ofLogNotice("ofxZED::Scraper") << "retrying segment" << segments[i].start << "-" << segments[i].end << "from" << segments[i].start + segments[i].frames.size();
+            run(segments[i]);
+        }
+        advance();
+        if (next == segments.size()) return true;
+
+        /*-- still stuck: keep what the failed segment got, anything after it can't be placed --*/
+
+        Segment & failed = segments[next];
+        frames.insert(frames.end(), failed.frames.begin(), failed.frames.end());
+        int discarded = 0;
+        for (int i = next + 1; i < segments.size(); i++) discarded += segments[i].frames.size();
+        ofLogError("ofxZED::Scraper") << "truncated at frame" << failed.start + failed.frames.size() << ", discarding" << discarded << "frames scraped after it";
+        if (onPrefix) onPrefix(frames);
+        return false;
+    }
+
+    /*-- a clean run, then one where a segment times out once and has to be retried --*/
+
+    bool Scraper::check(int total, int count) {
+
+        vector<Frame> table;
+        for (int i = 0; i < total; i++) table.push_back( Frame(i, 1000000000ULL + (uint64_t) i * 33333333ULL) );
+
+        bool ok = true;
+        for (int failAt : { -1, total / 2 + 1 }) {
+            vector<Frame> frames;
+            bool prefixOk = true;
+            PrefixCallback onPrefix = [&](const vector<Frame> & prefix) {
+                for (int i = 0; i < prefix.size(); i++) {
+                    if (prefix[i].frame != i || prefix[i].timestamp != table[i].timestamp) prefixOk = false;
+                }
+            };
+            /*-- only the first pass fails, the source opened for the retry reads through --*/
+            std::atomic<int> opened(0);
+            SourceFactory factory = [&table, &opened, failAt, count]() {
+                TableSource * source = new TableSource(table);
+                source->failAt = (opened++ < count) ? failAt : -1;
+                return std::unique_ptr<FrameSource>(source);
+            };
+
+            bool stitched = scrape(factory, 0, total, count, frames, onPrefix);
+            bool same = frames.size() == table.size();
+            for (int i = 0; same && i < frames.size(); i++) same = frames[i].frame == table[i].frame && frames[i].timestamp == table[i].timestamp;
+
+            ofLogNotice("ofxZED::Scraper") << "check" << total << "frames," << count << "segments, failing at" << failAt << ":" << ((stitched && same && prefixOk) ? "ok" : "FAILED");
+            ok = ok && stitched && same && prefixOk;
+        }
+        return ok;
+    }
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDCamera.h"
+#include "ofxZEDSVO.h"
+
+/*
+
+Scraper: splits one SVO into K segments and scrapes them side by side
+
+- every segment gets its own FrameSource (ie. its own Camera on the same SVO)
+- each worker seeks to its segment start and reads up to the segment end
+- segments are stitched back in order as they complete, checking frame indices and timestamps
+  at the seams, and onPrefix is called each time the contiguous prefix grows (ie. to checkpoint it)
+- a segment that stopped early is retried once from where it stopped with a fresh source, so the
+  complete segments after it are kept, only if the retry fails too is the result truncated there
+- what comes back is always a contiguous prefix
+
+**/
+
+
+namespace ofxZED {
+
+    /*-- anything that can seek to a frame and report its timestamp --*/
+
+    class FrameSource {
+    public:
+        virtual ~FrameSource() { }
+        virtual bool open() = 0;
+        virtual void close() { }
+        virtual int getNumberOfFrames() = 0;
+        virtual void seek(int frame) = 0;
+        virtual bool next(Frame & frame) = 0;
+    };
+
+    /*-- SVO through the ZED SDK, depth is disabled as only timestamps are read --*/
+
+    class CameraSource : public FrameSource {
+    public:
+        Camera camera;
+        string path;
+        float timeout;
+
+        CameraSource(string path_, float timeout_ = 2);
+        bool open();
+        void close();
+        int getNumberOfFrames();
+        void seek(int frame);
+        bool next(Frame & frame);
+    };
+
+    /*-- in-memory table, ie. for checking split / stitch without an SVO,
+     * failAt makes next() fail once at that frame, like an SVO grab timing out --*/
+
+    class TableSource : public FrameSource {
+    public:
+        vector<Frame> table;
+        int position;
+        int failAt;
+
+        TableSource(vector<Frame> table_);
+        bool open();
+        int getNumberOfFrames();
+        void seek(int frame);
+        bool next(Frame & frame);
+    };
+
+    struct Segment {
+    public:
+        int start;
+        int end;
+        bool isComplete;
+        vector<Frame> frames;
+        Segment(int start_, int end_) {
+            start = start_;
+            end = end_;
+            isComplete = false;
+        }
+    };
+
+    class Scraper {
+    public:
+
+        typedef std::function<std::unique_ptr<FrameSource>()> SourceFactory;
+        typedef std::function<void(const vector<Frame> & frames)> PrefixCallback;
+
+        static bool grab(Camera & camera, float timeout = 2);
+
+        static vector<Segment> split(int first, int total, int count);
+
+        /*-- reads on from whatever the segment already holds --*/
+        static void scrapeSegment(FrameSource & source, Segment & segment);
+
+        /*-- appends a complete segment, a frame index mismatch cuts the segment back to it --*/
+        static bool stitch(Segment & segment, vector<Frame> & frames);
+
+        static bool scrape(SourceFactory factory, int first, int total, int count, vector<Frame> & frames, PrefixCallback onPrefix = nullptr);
+
+        /*-- split / retry / stitch over a synthetic TableSource, false if anything came back wrong --*/
+        static bool check(int total = 10000, int count = 4);
+    };
+
+
+}
@@ -0,0 +1,121 @@
+#include "ofxZEDSyncTable.h"
+
+#include <queue>
+
+
+namespace ofxZED {
+
+    void SyncTable::clear() {
+        svos.clear();
+        starts.clear();
+        ends.clear();
+        events.clear();
+        indices.clear();
+        checkpoints.clear();
+    }
+
+    void SyncTable::build(vector<SVO *> svos_) {
+
+        float startTime = ofGetElapsedTimef();
+        clear();
+        svos = svos_;
+
+        /*-- heads of every frames table, smallest timestamp first --*/
+
+        typedef std::pair<uint64_t, std::pair<int, int>> Head;
+        std::priority_queue<Head, vector<Head>, std::greater<Head>> heads;
+
+        size_t total = 0;
+        for (int i = 0; i < svos.size(); i++) {
+            indices[svos[i]] = i;
+            svos[i]->checkForLookup();
+            starts.push_back(svos[i]->getStart());
+            ends.push_back(svos[i]->getEnd());
+            total += svos[i]->frames.size();
+            if (svos[i]->frames.size() > 0) heads.push( Head(svos[i]->frames[0].timestamp, std::make_pair(i, 0)) );
+        }
+        events.reserve(total);
+
+        /*-- a checkpoint is one int per SVO, never take one more often than that many events --*/
+
+        checkpointStride = std::max(std::max(checkpointInterval, 1), (int)svos.size());
+        checkpoints.reserve(total / checkpointStride + 1);
+
+        vector<int> state(svos.size(), -1);
+        while (!heads.empty()) {
+            Head head = heads.top();
+            heads.pop();
+            int i = head.second.first;
+            int k = head.second.second;
+
+            if (events.size() % checkpointStride == 0) checkpoints.push_back(state);
+
+            SyncEvent e;
+            e.timestamp = head.first;
+            e.svo = i;
+            e.frame = svos[i]->frames[k].frame;
+            events.push_back(e);
+            state[i] = e.frame;
+
+            if (k + 1 < svos[i]->frames.size()) heads.push( Head(svos[i]->frames[k+1].timestamp, std::make_pair(i, k + 1)) );
+        }
+
+        ofLogNotice("ofxZED::SyncTable") << "merged" << events.size() << "frames from" << svos.size() << "svos in" << ofGetElapsedTimef() - startTime << "s";
+    }
+
+    int SyncTable::getIndex(SVO * svo) {
+        auto it = indices.find(svo);
+        return (it != indices.end()) ? it->second : -1;
+    }
+
+    int SyncTable::getFrames(uint64_t time, vector<int> & frames) {
+
+        auto it = std::upper_bound(events.begin(), events.end(), time, [](uint64_t t, const SyncEvent & e) {
+            return t < e.timestamp;
+        });
+        int n = it - events.begin();
+        int c = std::min(n / checkpointStride, (int)checkpoints.size() - 1);
+
+        if (c < 0) {
+            frames.assign(svos.size(), -1);
+            return n;
+        }
+        frames = checkpoints[c];
+        for (int j = c * checkpointStride; j < n; j++) frames[events[j].svo] = events[j].frame;
+        for (int i = 0; i < svos.size(); i++) if (time > ends[i]) frames[i] = -1;
+        return n;
+    }
+
+    vector<int> SyncTable::getFrames(uint64_t time) {
+        vector<int> frames;
+        getFrames(time, frames);
+        return frames;
+    }
+
+    /*-- SyncCursor --*/
+
+    SyncCursor::SyncCursor(SyncTable & table_, uint64_t start) {
+        table = &table_;
+        timestamp = start;
+        index = table->getFrames(start, frames);
+    }
+
+    /*-- applies every event sharing the next timestamp, changed lists the SVOs that moved --*/
+
+    bool SyncCursor::next() {
+
+        changed.clear();
+        if (index >= table->events.size()) return false;
+
+        timestamp = table->events[index].timestamp;
+        while (index < table->events.size() && table->events[index].timestamp == timestamp) {
+            const SyncEvent & e = table->events[index++];
+            frames[e.svo] = e.frame;
+            changed.push_back(e.svo);
+        }
+        for (int i = 0; i < frames.size(); i++) if (timestamp > table->ends[i]) frames[i] = -1;
+        return true;
+    }
+
+
+}
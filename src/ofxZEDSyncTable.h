@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDSVO.h"
+
+/*
+
+SyncTable: one merged timeline over the frames tables of many SVOs (ie. every camera)
+
+- built by a k-way merge, every frame of every SVO becomes one event in timestamp order
+- the frame of every SVO is snapshotted every max(checkpointInterval, svos) events, so
+  checkpoints hold at most one int per event and a lookup is a binary search plus replaying
+  no more events than copying a checkpoint costs
+- frames are -1 for SVOs that do not cover the timestamp
+- SyncCursor walks synchronized frame tuples in order, ie. for multi-view processing
+
+**/
+
+
+namespace ofxZED {
+
+    struct SyncEvent {
+    public:
+        uint64_t timestamp;
+        int32_t svo;
+        int32_t frame;
+    };
+
+    class SyncTable {
+    private:
+        std::map<SVO *, int> indices;
+        vector<vector<int>> checkpoints;
+        int checkpointStride;
+    public:
+
+        vector<SVO *> svos;
+        vector<uint64_t> starts;
+        vector<uint64_t> ends;
+        vector<SyncEvent> events;
+        int checkpointInterval;
+
+        SyncTable() { checkpointInterval = 256; checkpointStride = 256; };
+
+        void build(vector<SVO *> svos_);
+        void clear();
+
+        /*-- frame of every SVO at a timestamp, in the order of svos --*/
+        vector<int> getFrames(uint64_t time);
+
+        int getIndex(SVO * svo);
+
+        /*-- index of the first event after a timestamp, and the frames just before it --*/
+        int getFrames(uint64_t time, vector<int> & frames);
+    };
+
+    class SyncCursor {
+    private:
+        SyncTable * table;
+        int index;
+    public:
+
+        uint64_t timestamp;
+        vector<int> frames;
+        vector<int> changed;
+
+        /*-- positioned on the tuple at start, next() then moves to the following timestamp --*/
+        SyncCursor(SyncTable & table_, uint64_t start);
+        bool next();
+    };
+
+
+}
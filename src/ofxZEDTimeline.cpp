@@ -6,6 +6,20 @@ namespace ofxZED {
     Timeline::Timeline() {
         isPlaying = false;
         grabOnce = false;
+        rate = 1;
+        minRate = 1.0 / 16.0;
+        maxRate = 32;
+        keyframeStride = 0;
+        strideRate = 4;
+    }
+
+    void Timeline::setRate(float rate_) {
+        float magnitude = ofClamp(std::abs(rate_), minRate, maxRate);
+        rate = (rate_ < 0) ? -magnitude : magnitude;
+    }
+
+    float Timeline::getRate() {
+        return rate;
     }
 
     void Timeline::init() {
@@ -13,27 +27,28 @@ namespace ofxZED {
         ofRegisterMouseEvents(this);
     }
     void Timeline::load(vector<SVO *> svos_) {
-        vector<string> names;
-        for (auto & s : svos_) names.push_back(s->getName());
-        for (auto & p : players) {
-            if ( std::find(names.begin(), names.end(), p.first) == names.end()) {
-                ofLog() << "deleting" << p.first;
-                p.second->close();
-                players.erase( p.first );
+        std::set<string> paths;
+        for (auto & s : svos_) paths.insert(s->getSVOPath());
+        for (auto it = players.begin(); it != players.end(); ) {
+            if ( paths.find(it->first) == paths.end()) {
+                ofLog() << "releasing" << it->first;
+                pool.release(it->first);
+                it = players.erase(it);
+            } else {
+                ++it;
             }
         }
 
         for (auto & s : svos_) {
-            string name = s->getName();
-            if ( players.find(name) == players.end()) {
-                string path = s->getSVOPath();
+            string path = s->getSVOPath();
+            if ( players.find(path) == players.end()) {
                 ofLog() << "loading" << path;
-//                ofxZED::Player player;
-                players[path] = new ofxZED::Player();
-                players[path]->openSVO( s );
+                ofxZED::Player * p = pool.acquire( s );
+                if (p) players[path] = p;
             }
         }
 
+        ofLogNotice("ofxZED::Timeline") << "players" << pool.printInfo();
     }
 
     void Timeline::set(vector<SVO *> svos_, bool load) {
@@ -43,6 +58,7 @@ namespace ofxZED {
             mapped[s->getSVOPath()] = s;
         }
         ofSort(svos, ofxZED::SVO::sortSVOPtrs);
+        sync.build(svos);
     }
 
 
@@ -151,7 +167,9 @@ namespace ofxZED {
                 ofxZED::SVO * svo = mapped[player.first];
                 ofxZED::Player * p = player.second;
                 if (p->left || p->right || p->depth || p->cloud) {
-                    uint64_t t = svo->frames[player.second->getSVOPosition()].timestamp;
+                    int frame = p->getDisplayedFrame();
+                    if (frame < 0) continue;
+                    uint64_t t = svo->getTimestamp(frame);
                     float xx = ofxZED::SVO::mapFromTimestamp(t, getStart(), getEnd(), 0, w, true );
                     playheads.push_back((int)xx);
                 }
@@ -202,36 +220,46 @@ namespace ofxZED {
 
     bool Timeline::update() {
 
+        static Histogram & updateTime = Metrics::histogram("timeline.update");
+        static Gauge & playerCount = Metrics::gauge("timeline.players");
+        ScopedTimer timer(updateTime);
+        OFXZED_TRACE("Timeline::update");
+        playerCount.set(players.size());
+
         bool setViaPlayer = false;
 
+        /*-- scrubbing posts seeks, each player decodes only the latest one --*/
 
-//        ofLog() << "grab video" << p->left << left;
-        if (isPlaying || grabOnce) {
-            uint64_t t = 0;
-            uint64_t total = 0;
-            if (players.size() > 0) {
+        for (auto & player : players) {
+            if (player.second->update()) setViaPlayer = true;
+        }
 
-                for (auto & player : players) {
-                    ofxZED::Player * p = player.second;
-                    if (p->left || p->right || p->depth || p->cloud) {
-//                        ofLog() << "grabbing video";
-                        p->grab();
-                        setViaPlayer = true;
-                        ofxZED::SVO * svo = mapped[player.first];
-                        uint64_t t = svo->frames[p->getSVOPosition()].timestamp;
-                        total += t;
+        if (isPlaying) {
 
+            /*-- time drives playback, players show whatever frame is current at the new time --*/
 
-                        currentTime = t;
-                    }
-                }
+            int64_t start = getStart();
+            int64_t end = getEnd();
+            int64_t t = currentTime + (int64_t) (ofGetLastFrameTime() * rate * 1000000000.0);
+            if (t >= end || t <= start) {
+                t = std::min(std::max(t, start), end);
+                isPlaying = false;
             }
+            currentTime = t;
+            setViaPlayer = showTime(currentTime);
 
-//            if (setViaPlayer) currentTime = total/players.size();
+        } else if (grabOnce) {
+            for (auto & player : players) {
+                ofxZED::Player * p = player.second;
+                if (p->left || p->right || p->depth || p->cloud) {
+                    p->grab();
+                    setViaPlayer = true;
+                    ofxZED::SVO * svo = mapped[player.first];
+                    currentTime = svo->getTimestamp(p->getSVOPosition());
+                }
+            }
         }
 
-
-
         if (grabOnce) grabOnce = false;
 
         if (!setViaPlayer && isPlaying) return true;
@@ -239,6 +267,30 @@ namespace ofxZED {
     }
 
 
+    /*-- below strideRate forward, gaps of up to a keyframe interval are decoded through rather than
+     * seeked, at high rates and in reverse (where every step back is a seek) targets snap to
+     * keyframeStride, stepping keyframes instead of decoding every frame --*/
+
+    bool Timeline::showTime(uint64_t time) {
+
+        vector<int> targets = sync.getFrames(time);
+        bool shown = false;
+        for (auto & player : players) {
+            ofxZED::Player * p = player.second;
+            if (!(p->left || p->right || p->depth || p->cloud)) continue;
+            int i = sync.getIndex(mapped[player.first]);
+            if (i < 0 || targets[i] < 0) continue;
+
+            int target = targets[i];
+            int stride = (keyframeStride > 0) ? keyframeStride : mapped[player.first]->fps;
+            bool isSnapped = stride > 1 && (rate < 0 || std::abs(rate) >= strideRate);
+            if (isSnapped) target -= target % stride;
+            p->showFrame(target, isSnapped ? 1 : std::max(1, stride));
+            shown = true;
+        }
+        return shown;
+    }
+
     void Timeline::setSVOFromXY(int x, int y) {
 
 
@@ -254,6 +306,7 @@ namespace ofxZED {
 
 
         currentTime = ofxZED::SVO::mapToTimestamp(x, timelineRect.getLeft(), timelineRect.getRight(), getStart(), getEnd(), true);
+        vector<int> frames = sync.getFrames(currentTime);
 
         for (auto & player : players) {
 
@@ -261,12 +314,14 @@ namespace ofxZED {
 
             if (p->left || p->right || p->depth || p->cloud) {
                 ofxZED::SVO * svo = mapped[player.first];
-                svo->checkForLookup();
-                int lookupIdx = ofxZED::SVO::mapFromTimestamp(currentTime, svo->getStart(), svo->getEnd(), 0, svo->getTotalLookupFrames(), true);
-                int frame = svo->getLookupIndex(lookupIdx);
-                p->setSVOPosition(frame);
+                int i = sync.getIndex(svo);
+                int frame = (i >= 0) ? frames[i] : -1;
+
+                /*-- outside its own range a player holds its first or last frame --*/
 
-                if (!isPlaying) grabOnce = true;
+                if (frame < 0 && svo->frames.size() > 0) frame = svo->frames[svo->getFrameFromTimestamp(currentTime)].frame;
+                if (frame < 0) continue;
+                p->requestFrame(frame);
             }
         }
     }
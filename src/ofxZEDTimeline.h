@@ -4,6 +4,8 @@
 #include "ofxZEDSVO.h"
 #include "ofxZEDDatabase.h"
 #include "ofxZEDPlayer.h"
+#include "ofxZEDPlayerPool.h"
+#include "ofxZEDSyncTable.h"
 #include "ofxDatGuiTheme.h"
 #include <sl/Camera.hpp>
 
@@ -52,6 +54,9 @@ namespace ofxZED {
 
         uint64_t currentTime;
         std::map<string, ofxZED::Player *> players;
+
+        /*-- owns the Players, those dropped by load() stay warm until evicted --*/
+        PlayerPool pool;
         std::map<string, ofxZED::SVO *> mapped;
 
         /*-- ui vars --*/
@@ -65,6 +70,23 @@ namespace ofxZED {
 
         bool grabOnce;
 
+        /*-- playback rate, negative plays in reverse, magnitude between minRate and maxRate --*/
+
+        float rate;
+        float minRate;
+        float maxRate;
+
+        /*-- above strideRate and in reverse, targets snap to multiples of keyframeStride so seeks land
+         * on keyframes, below it forward gaps up to keyframeStride are decoded through instead of
+         * seeked, 0 (the default) takes each recording's nominal fps, ie. a GOP of one second as the
+         * compressed SVO modes write, set the GOP explicitly for other encodes, 1 never snaps --*/
+
+        int keyframeStride;
+        float strideRate;
+
+        void setRate(float rate_);
+        float getRate();
+
         void mouseMoved(ofMouseEventArgs & e );
         void mouseDragged(ofMouseEventArgs & e);
         void mousePressed(ofMouseEventArgs & e);
@@ -77,6 +99,10 @@ namespace ofxZED {
 
         vector<ofxZED::SVO *> svos;
 
+        /*-- frames of every SVO per timestamp, rebuilt by set() --*/
+
+        ofxZED::SyncTable sync;
+
         /*-- database and players --*/
 
         ofxZED::Database * db;
@@ -89,6 +115,7 @@ namespace ofxZED {
         void set(vector<SVO *> svos_, bool load = false);
 
         bool update();
+        bool showTime(uint64_t time);
 
         uint64_t getStart();
         uint64_t getEnd();
@@ -0,0 +1,115 @@
+#include "ofxZEDTrace.h"
+
+
+namespace ofxZED {
+
+    std::mutex Trace::mutex;
+    vector<std::shared_ptr<TraceBuffer>> Trace::buffers;
+    std::atomic<int64_t> Trace::origin(0);
+    std::atomic<bool> Trace::enabled(false);
+    int Trace::maxEvents = 1 << 20;
+
+    void Trace::start() {
+        clear();
+        origin.store(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        enabled.store(true);
+        ofLogNotice("ofxZED::Trace") << "tracing started";
+    }
+
+    void Trace::stop() {
+        enabled.store(false);
+        ofLogNotice("ofxZED::Trace") << "tracing stopped";
+    }
+
+    void Trace::clear() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto & buffer : buffers) {
+            std::unique_lock<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+    }
+
+    uint64_t Trace::now() {
+        int64_t t = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        return t - origin.load(std::memory_order_relaxed);
+    }
+
+    /*-- buffers are owned by the registry, so they outlive the threads that filled them --*/
+
+    TraceBuffer & Trace::getBuffer() {
+        thread_local TraceBuffer * local = nullptr;
+        if (!local) {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::shared_ptr<TraceBuffer> buffer = std::make_shared<TraceBuffer>();
+            buffer->tid = buffers.size() + 1;
+            buffer->dropped = 0;
+            buffers.push_back(buffer);
+            local = buffer.get();
+        }
+        return *local;
+    }
+
+    void Trace::add(const char * name, uint64_t start, uint64_t duration) {
+        TraceBuffer & buffer = getBuffer();
+        std::unique_lock<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= maxEvents) {
+            buffer.dropped++;
+            return;
+        }
+        TraceEvent e;
+        e.name = name;
+        e.start = start;
+        e.duration = duration;
+        buffer.events.push_back(e);
+    }
+
+    /*-- complete ("X") events, one array, streamed rather than built as one ofJson --*/
+
+    bool Trace::write(string path) {
+
+        std::ofstream out(ofToDataPath(path), std::ios::trunc);
+        if (!out) {
+            ofLogError("ofxZED::Trace") << "could not write" << path;
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        uint64_t dropped = 0;
+        bool first = true;
+        out << "{\"traceEvents\":[";
+        for (auto & buffer : buffers) {
+            std::unique_lock<std::mutex> bufferLock(buffer->mutex);
+            if (!first) out << ",";
+            first = false;
+            out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid;
+            out << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+            for (auto & e : buffer->events) {
+                out << ",\n{\"name\":" << ofJson(e.name).dump() << ",\"cat\":\"ofxZED\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid;
+                out << ",\"ts\":" << e.start << ",\"dur\":" << e.duration << "}";
+            }
+            total += buffer->events.size();
+            dropped += buffer->dropped;
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        ofLogNotice("ofxZED::Trace") << "wrote" << total << "events to" << path << "," << dropped << "dropped";
+        return (bool) out;
+    }
+
+    /*-- TraceScope --*/
+
+    TraceScope::TraceScope(const char * name_) {
+        name = Trace::enabled.load(std::memory_order_relaxed) ? name_ : nullptr;
+        if (name) start = Trace::now();
+    }
+
+    TraceScope::~TraceScope() {
+        if (!name) return;
+        uint64_t end = Trace::now();
+        Trace::add(name, start, end - start);
+    }
+
+
+}
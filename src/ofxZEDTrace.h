@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+
+Trace: scoped events written as Chrome trace-event JSON (chrome://tracing, Perfetto)
+
+- every thread appends to its own buffer, only registering a new thread takes the global lock
+- buffers are capped at maxEvents per thread, further events are counted as dropped
+- names must be string literals (or otherwise outlive the trace), only the pointer is kept
+- with tracing stopped a scope is one relaxed atomic load
+
+    ofxZED::Trace::start();
+    {
+        OFXZED_TRACE("grab");
+        ...
+    }
+    ofxZED::Trace::stop();
+    ofxZED::Trace::write("trace.json");
+
+**/
+
+#define OFXZED_TRACE_CONCAT_(a, b) a##b
+#define OFXZED_TRACE_CONCAT(a, b) OFXZED_TRACE_CONCAT_(a, b)
+#define OFXZED_TRACE(name) ofxZED::TraceScope OFXZED_TRACE_CONCAT(ofxZEDTraceScope, __LINE__)(name)
+
+
+namespace ofxZED {
+
+    struct TraceEvent {
+    public:
+        const char * name;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct TraceBuffer {
+    public:
+        int tid;
+        uint64_t dropped;
+        std::mutex mutex;
+        vector<TraceEvent> events;
+    };
+
+    class Trace {
+    private:
+        static std::mutex mutex;
+        static vector<std::shared_ptr<TraceBuffer>> buffers;
+        static std::atomic<int64_t> origin;
+    public:
+
+        static std::atomic<bool> enabled;
+        static int maxEvents;
+
+        static void start();
+        static void stop();
+        static void clear();
+
+        /*-- microseconds since the trace started --*/
+        static uint64_t now();
+
+        static TraceBuffer & getBuffer();
+        static void add(const char * name, uint64_t start, uint64_t duration);
+
+        static bool write(string path);
+    };
+
+    class TraceScope {
+    private:
+        const char * name;
+        uint64_t start;
+    public:
+        TraceScope(const char * name_);
+        ~TraceScope();
+    };
+
+
+}
@@ -0,0 +1,198 @@
+#include "ofxZEDVoxelGrid.h"
+#include "ofxZEDMetrics.h"
+#include "ofxZEDTrace.h"
+
+
+namespace ofxZED {
+
+    VoxelGrid::VoxelGrid() {
+        frame = 0;
+        voxelSize = 0.05;
+        threads = 1;
+        accumulate = 1;
+        decay = 0.5;
+        minWeight = 0.01;
+    }
+
+    /*-- cells are offset by 2^20 so negative coordinates stay positive in their 21 bits --*/
+
+    uint64_t VoxelGrid::getKey(float x, float y, float z, float inverse) {
+        const int64_t offset = 1 << 20;
+        const uint64_t mask = (1 << 21) - 1;
+        uint64_t ix = (uint64_t) ((int64_t) std::floor(x * inverse) + offset) & mask;
+        uint64_t iy = (uint64_t) ((int64_t) std::floor(y * inverse) + offset) & mask;
+        uint64_t iz = (uint64_t) ((int64_t) std::floor(z * inverse) + offset) & mask;
+        return (ix << 42) | (iy << 21) | iz;
+    }
+
+    void VoxelGrid::addBand(const float * src, int w, int from, int to, int step, std::unordered_map<uint64_t, Voxel> & out) {
+        float inverse = 1.0 / std::max(voxelSize, 0.0001f);
+        for (int y = from; y < to; y++) {
+            const float * row = src + (size_t) y * step;
+            for (int x = 0; x < w; x++) {
+                const float * p = row + x * 4;
+                if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+                const unsigned char * c = (const unsigned char *) (p + 3);
+                Voxel & v = out[getKey(p[0], p[1], p[2], inverse)];
+                v.x += p[0];
+                v.y += p[1];
+                v.z += p[2];
+                v.r += c[0];
+                v.g += c[1];
+                v.b += c[2];
+                v.weight += 1;
+            }
+        }
+    }
+
+    void VoxelGrid::add(const float * src, int w, int h, int step) {
+
+        static Histogram & addTime = Metrics::histogram("voxels.add");
+        static Gauge & count = Metrics::gauge("voxels.count");
+        ScopedTimer timer(addTime);
+        OFXZED_TRACE("VoxelGrid::add");
+
+        /*-- fade the sums with the weight, so averages are unchanged and newer points count more --*/
+
+        frame++;
+        if (accumulate <= 1) {
+            voxels.clear();
+        } else {
+            for (auto it = voxels.begin(); it != voxels.end(); ) {
+                Voxel & v = it->second;
+                v.x *= decay;
+                v.y *= decay;
+                v.z *= decay;
+                v.r *= decay;
+                v.g *= decay;
+                v.b *= decay;
+                v.weight *= decay;
+                if (frame - v.lastSeen >= accumulate || v.weight < minWeight) {
+                    it = voxels.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        int bands = std::min(std::max(1, threads), std::max(1, h));
+        int rows = (h + bands - 1) / bands;
+        vector<std::unordered_map<uint64_t, Voxel>> local(bands);
+        vector<std::thread> pool;
+        for (int i = 1; i < bands; i++) {
+            pool.emplace_back(&VoxelGrid::addBand, this, src, w, i * rows, std::min(h, (i + 1) * rows), step, std::ref(local[i]));
+        }
+        addBand(src, w, 0, std::min(h, rows), step, local[0]);
+        for (auto & t : pool) t.join();
+
+        for (auto & band : local) {
+            for (auto & e : band) {
+                Voxel & v = voxels[e.first];
+                v.x += e.second.x;
+                v.y += e.second.y;
+                v.z += e.second.z;
+                v.r += e.second.r;
+                v.g += e.second.g;
+                v.b += e.second.b;
+                v.weight += e.second.weight;
+                v.lastSeen = frame;
+            }
+        }
+        count.set(voxels.size());
+    }
+
+    void VoxelGrid::clear() {
+        voxels.clear();
+        frame = 0;
+    }
+
+    size_t VoxelGrid::size() {
+        return voxels.size();
+    }
+
+    void VoxelGrid::getPoints(vector<glm::vec3> & points, vector<ofFloatColor> & colors) {
+        points.clear();
+        colors.clear();
+        points.reserve(voxels.size());
+        colors.reserve(voxels.size());
+        for (auto & e : voxels) {
+            const Voxel & v = e.second;
+            float inverse = 1.0 / v.weight;
+            points.push_back(glm::vec3(v.x * inverse, v.y * inverse, v.z * inverse));
+            colors.push_back(ofFloatColor(v.r * inverse / 255.0, v.g * inverse / 255.0, v.b * inverse / 255.0, 1));
+        }
+    }
+
+    void VoxelGrid::getMesh(ofMesh & mesh) {
+        vector<glm::vec3> points;
+        vector<ofFloatColor> colors;
+        getPoints(points, colors);
+        mesh.clear();
+        mesh.setMode(OF_PRIMITIVE_POINTS);
+        mesh.addVertices(points);
+        mesh.addColors(colors);
+    }
+
+    /*-- every voxel of 0.1 gets 4x4 points at z 1.05, every 7th point is a hole --*/
+
+    bool VoxelGrid::check(int w, int h) {
+
+        int step = w * 4 + 8;
+        vector<float> cloud((size_t) step * h, std::numeric_limits<float>::quiet_NaN());
+        vector<float> empty(cloud.size(), std::numeric_limits<float>::quiet_NaN());
+        const unsigned char rgba[4] = { 200, 100, 50, 255 };
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                if ((x + y * w) % 7 == 0) continue;
+                float * p = &cloud[(size_t) y * step + x * 4];
+                p[0] = (x + 0.5f) * 0.025f;
+                p[1] = (y + 0.5f) * 0.025f;
+                p[2] = 1.05f;
+                std::memcpy(p + 3, rgba, 4);
+            }
+        }
+        size_t expected = (size_t) ((w + 3) / 4) * ((h + 3) / 4);
+
+        auto isAveraged = [](VoxelGrid & grid) {
+            vector<glm::vec3> points;
+            vector<ofFloatColor> colors;
+            grid.getPoints(points, colors);
+            for (int i = 0; i < points.size(); i++) {
+                float cx = (std::floor(points[i].x / grid.voxelSize) + 0.5f) * grid.voxelSize;
+                float cy = (std::floor(points[i].y / grid.voxelSize) + 0.5f) * grid.voxelSize;
+                float half = grid.voxelSize * 0.5f;
+                if (std::abs(points[i].x - cx) > half || std::abs(points[i].y - cy) > half || std::abs(points[i].z - 1.05f) > 1e-4) return false;
+                if (std::abs(colors[i].r - 200 / 255.0f) > 1e-3 || std::abs(colors[i].g - 100 / 255.0f) > 1e-3 || std::abs(colors[i].b - 50 / 255.0f) > 1e-3) return false;
+            }
+            return true;
+        };
+
+        bool ok = true;
+        for (int threads : { 1, 3, 8 }) {
+            VoxelGrid grid;
+            grid.voxelSize = 0.1;
+            grid.threads = threads;
+            grid.add(cloud.data(), w, h, step);
+            bool passed = grid.size() == expected && isAveraged(grid);
+            ofLogNotice("ofxZED::VoxelGrid") << "check" << threads << "threads:" << grid.size() << "of" << expected << "voxels" << (passed ? "ok" : "FAILED");
+            ok = ok && passed;
+        }
+
+        /*-- accumulated voxels survive accumulate - 1 empty frames, then expire --*/
+
+        VoxelGrid grid;
+        grid.voxelSize = 0.1;
+        grid.accumulate = 3;
+        grid.decay = 0.9;
+        grid.add(cloud.data(), w, h, step);
+        grid.add(empty.data(), w, h, step);
+        grid.add(empty.data(), w, h, step);
+        bool kept = grid.size() == expected && isAveraged(grid);
+        grid.add(empty.data(), w, h, step);
+        bool expired = grid.size() == 0;
+        ofLogNotice("ofxZED::VoxelGrid") << "check accumulate:" << ((kept && expired) ? "ok" : "FAILED");
+        return ok && kept && expired;
+    }
+
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+
+VoxelGrid: downsamples XYZRGBA point clouds (sl::MEASURE_XYZRGBA) to one averaged point per voxel
+
+- voxels live in a hash map keyed by their integer cell, 21 bits per axis
+- each frame is split into row bands, every band fills its own map, the maps are merged after
+- with accumulate > 1 voxels persist for that many frames, their weight multiplied by decay
+  every frame, so older points fade out of the average rather than vanish
+- NaN and inf points (no depth) are skipped
+
+    ofxZED::VoxelGrid grid;
+    grid.voxelSize = 0.05;
+    grid.add(cloudMat.getPtr<sl::float1>(), w, h, cloudMat.getStepBytes() / sizeof(float));
+    grid.getMesh(mesh);
+
+**/
+
+
+namespace ofxZED {
+
+    struct Voxel {
+    public:
+        float x = 0, y = 0, z = 0;
+        float r = 0, g = 0, b = 0;
+        float weight = 0;
+        int lastSeen = 0;
+    };
+
+    class VoxelGrid {
+    private:
+        std::unordered_map<uint64_t, Voxel> voxels;
+        int frame;
+        uint64_t getKey(float x, float y, float z, float inverse);
+        void addBand(const float * src, int w, int from, int to, int step, std::unordered_map<uint64_t, Voxel> & out);
+    public:
+
+        float voxelSize;
+        int threads;
+        int accumulate;
+        float decay;
+
+        /*-- voxels below this weight are dropped before accumulate runs out --*/
+        float minWeight;
+
+        VoxelGrid();
+
+        /*-- one frame of 4 floats per point (x, y, z, packed rgba), step in floats per row --*/
+        void add(const float * src, int w, int h, int step);
+        void clear();
+
+        size_t size();
+        void getPoints(vector<glm::vec3> & points, vector<ofFloatColor> & colors);
+        void getMesh(ofMesh & mesh);
+
+        /*-- runs synthetic clouds (padded rows, NaN holes) through one and several threads and
+         * accumulate, false if counts, averages or colours came back wrong --*/
+        static bool check(int w = 64, int h = 48);
+    };
+
+
+}
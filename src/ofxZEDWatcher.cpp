@@ -0,0 +1,189 @@
+#include "ofxZEDWatcher.h"
+
+#ifdef TARGET_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+namespace ofxZED {
+
+    Watcher::Watcher() {
+        db = nullptr;
+        fd = -1;
+        wd = -1;
+        settleTime = 5;
+        isRescanPending = false;
+    }
+
+    Watcher::~Watcher() {
+        stop();
+    }
+
+    bool Watcher::start(Database * db_) {
+
+        db = db_;
+        directory = db->getDirectoryPath();
+
+#ifdef TARGET_LINUX
+        fd = inotify_init1(IN_NONBLOCK);
+        if (fd < 0) {
+            ofLogError("ofxZED::Watcher") << "could not initialise inotify";
+            return false;
+        }
+        uint32_t mask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE;
+        wd = inotify_add_watch(fd, directory.c_str(), mask);
+        if (wd < 0) {
+            ofLogError("ofxZED::Watcher") << "could not watch" << directory;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        ofLogNotice("ofxZED::Watcher") << "watching" << directory;
+        startThread();
+        return true;
+#else
+        ofLogError("ofxZED::Watcher") << "watching is only supported on linux";
+        return false;
+#endif
+    }
+
+    void Watcher::stop() {
+
+        if (isThreadRunning()) waitForThread(true);
+#ifdef TARGET_LINUX
+        if (fd >= 0) {
+            if (wd >= 0) inotify_rm_watch(fd, wd);
+            ::close(fd);
+        }
+#endif
+        fd = -1;
+        wd = -1;
+    }
+
+    int Watcher::getNumPending() {
+        std::unique_lock<std::mutex> lck(mutex);
+        return pending.size();
+    }
+
+    bool Watcher::isSVO(string name) {
+        return ofToLower(ofFilePath::getFileExt(name)) == "svo";
+    }
+
+    void Watcher::threadedFunction() {
+
+#ifdef TARGET_LINUX
+        while (isThreadRunning()) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 200) > 0 && (pfd.revents & POLLIN)) readEvents();
+            processPending();
+        }
+#endif
+    }
+
+    void Watcher::readEvents() {
+
+#ifdef TARGET_LINUX
+        char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        ssize_t len;
+        float now = ofGetElapsedTimef();
+
+        std::unique_lock<std::mutex> lck(mutex);
+        while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char * ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event *) ptr)->len) {
+
+                const struct inotify_event * event = (const struct inotify_event *) ptr;
+
+                /*-- the kernel queue overflowed and events were lost, only a full rescan catches up --*/
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    if (!isRescanPending) ofLogWarning("ofxZED::Watcher") << "inotify queue overflowed, rescanning" << directory;
+                    isRescanPending = true;
+                    continue;
+                }
+                if (event->len == 0) continue;
+                string name(event->name);
+
+                /*-- renames arrive as a MOVED_FROM / MOVED_TO pair sharing a cookie --*/
+
+                if (event->mask & IN_MOVED_FROM) {
+                    if (isSVO(name)) moves[event->cookie] = std::make_pair(name, now);
+                } else if (event->mask & IN_MOVED_TO) {
+                    auto it = moves.find(event->cookie);
+                    if (it != moves.end() && isSVO(name)) {
+                        string from = it->second.first;
+                        moves.erase(it);
+                        lck.unlock();
+                        db->renameEntry(from, name);
+                        lck.lock();
+                    } else if (it != moves.end()) {
+                        string from = it->second.first;
+                        moves.erase(it);
+                        lck.unlock();
+                        db->removeEntry(from);
+                        lck.lock();
+                    } else if (isSVO(name)) {
+                        pending[name] = now - settleTime;
+                    }
+                } else if (event->mask & IN_DELETE) {
+                    if (isSVO(name)) {
+                        pending.erase(name);
+                        lck.unlock();
+                        db->removeEntry(name);
+                        lck.lock();
+                    }
+                } else if (event->mask & IN_CLOSE_WRITE) {
+                    if (isSVO(name)) pending[name] = now - settleTime;
+                } else if (event->mask & (IN_CREATE | IN_MODIFY)) {
+                    if (isSVO(name)) pending[name] = now;
+                }
+            }
+        }
+#endif
+    }
+
+    /*-- scrape files that have stopped changing, drop moves that never landed --*/
+
+    void Watcher::processPending() {
+
+        float now = ofGetElapsedTimef();
+        vector<string> ready, removed;
+        bool isRescanning = false;
+        {
+            std::unique_lock<std::mutex> lck(mutex);
+            isRescanning = isRescanPending;
+            isRescanPending = false;
+            for (auto it = pending.begin(); it != pending.end(); ) {
+                if (now - it->second >= settleTime) {
+                    ready.push_back(it->first);
+                    it = pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            for (auto it = moves.begin(); it != moves.end(); ) {
+                if (now - it->second.second >= 1) {
+                    removed.push_back(it->second.first);
+                    it = moves.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        /*-- validate() scrapes new and changed files, files it found missing were deleted --*/
+
+        if (isRescanning) {
+            db->validate();
+            for (auto & name : vector<string>(db->missing)) removed.push_back(name);
+        }
+        for (auto & name : removed) db->removeEntry(name);
+        for (auto & name : ready) {
+            if (!isThreadRunning()) return;
+            db->updateEntry(ofFilePath::join(directory, name));
+        }
+    }
+
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxZEDDatabase.h"
+
+/*
+
+Watcher: live incremental indexing of a Database directory (linux / inotify)
+
+- new or grown .svo files are scraped once they have settled (closed, or untouched for settleTime)
+- renamed .svo files keep their tables, only paths and sidecars are moved
+- deleted .svo files are removed from data and the manifest
+- when the inotify queue overflows, the directory is revalidated (see Database::validate)
+- all work happens on the watcher thread, read the results with Database::getSnapshot()
+
+**/
+
+
+namespace ofxZED {
+
+    class Watcher : public ofThread {
+    private:
+
+        Database * db;
+        string directory;
+        int fd, wd;
+
+        std::map<string, float> pending;
+        std::map<uint32_t, std::pair<string, float>> moves;
+
+        /*-- set on IN_Q_OVERFLOW, the thread then revalidates the whole directory --*/
+        bool isRescanPending;
+
+        bool isSVO(string name);
+        void readEvents();
+        void processPending();
+
+    protected:
+
+        void threadedFunction();
+
+    public:
+
+        float settleTime;
+
+        Watcher();
+        ~Watcher();
+
+        bool start(Database * db_);
+        void stop();
+        int getNumPending();
+    };
+
+
+}